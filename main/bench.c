@@ -0,0 +1,270 @@
+/*
+ * Rendering Microbenchmarks Implementation
+ */
+
+#include "bench.h"
+#include "ssd1306.h"
+#include "sprites.h"
+#include "particles.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "bench";
+
+#define BENCH_ITERATIONS  2000
+#define BENCH_FRAMES      200
+
+// ============================================================================
+// HARNESS
+// ============================================================================
+
+// Average time per call in nanoseconds
+static uint32_t bench_time_ns(void (*fn)(void)) {
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        fn();
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start;
+    return (uint32_t)(elapsed_us * 1000 / BENCH_ITERATIONS);
+}
+
+void bench_compare(const char *name, void (*before)(void), void (*after)(void)) {
+    uint32_t before_ns = bench_time_ns(before);
+    uint32_t after_ns = bench_time_ns(after);
+    uint32_t speedup_x10 = after_ns ? (before_ns * 10 / after_ns) : 0;
+    ESP_LOGI(TAG, "%-22s %7lu ns -> %7lu ns (%lu.%lux)", name,
+             (unsigned long)before_ns, (unsigned long)after_ns,
+             (unsigned long)(speedup_x10 / 10), (unsigned long)(speedup_x10 % 10));
+}
+
+// Reference: the per-pixel rectangle fill all primitives used to reduce to
+static void fill_rect_per_pixel(int x, int y, int w, int h, bool on) {
+    for (int j = y; j < y + h; j++) {
+        for (int i = x; i < x + w; i++) {
+            ssd1306_set_pixel(i, j, on);
+        }
+    }
+}
+
+// ============================================================================
+// RECTANGLE FILLS
+// ============================================================================
+
+// Wink eye clear: 44x38 at the right eye, not page aligned
+static void wink_clear_before(void) { fill_rect_per_pixel(74, 7, 44, 38, true); }
+static void wink_clear_after(void)  { ssd1306_fill_rect(74, 7, 44, 38, true); }
+
+// Sprite blink covers: two 28x12 strips per eye
+static void blink_cover_before(void) {
+    fill_rect_per_pixel(14, 18, 28, 12, false);
+    fill_rect_per_pixel(14, 30, 28, 12, false);
+    fill_rect_per_pixel(82, 18, 28, 12, false);
+    fill_rect_per_pixel(82, 30, 28, 12, false);
+}
+static void blink_cover_after(void) {
+    ssd1306_fill_rect(14, 18, 28, 12, false);
+    ssd1306_fill_rect(14, 30, 28, 12, false);
+    ssd1306_fill_rect(82, 18, 28, 12, false);
+    ssd1306_fill_rect(82, 30, 28, 12, false);
+}
+
+// Mouth interior: short horizontal spans
+static void hline_before(void) {
+    for (int y = 40; y < 45; y++) fill_rect_per_pixel(52, y, 25, 1, false);
+}
+static void hline_after(void) {
+    for (int y = 40; y < 45; y++) ssd1306_hline(52, y, 25, false);
+}
+
+// ============================================================================
+// CIRCLES AND ELLIPSES
+// ============================================================================
+
+// Iris-sized ellipse: old float per-pixel test vs one span per row
+static void ellipse_before(void) {
+    for (int dy = -9; dy <= 9; dy++) {
+        for (int dx = -11; dx <= 11; dx++) {
+            float ex = (float)dx / 11;
+            float ey = (float)dy / 9;
+            if (ex*ex + ey*ey <= 1.0f) {
+                ssd1306_set_pixel(40 + dx, 30 + dy, true);
+            }
+        }
+    }
+}
+static void ellipse_after(void) { ssd1306_fill_ellipse(40, 30, 11, 9, true); }
+
+static uint8_t checker_row(int y, void *user) {
+    (void)user;
+    return (y & 1) ? 0x55 : 0xAA;
+}
+static void ellipse_dither_after(void) {
+    ssd1306_fill_ellipse_pattern(40, 30, 11, 9, checker_row, NULL);
+}
+
+static void circle_before(void) {
+    for (int y = -10; y <= 10; y++) {
+        for (int x = -10; x <= 10; x++) {
+            if (x * x + y * y <= 100) {
+                ssd1306_set_pixel(64 + x, 32 + y, true);
+            }
+        }
+    }
+}
+static void circle_after(void) { ssd1306_fill_circle(64, 32, 10, true); }
+
+// ============================================================================
+// PIXEL ACCESS
+// ============================================================================
+
+// Star-sized shape, 256 pixels along four diagonals: bounds-checked by the
+// caller and again by set_pixel, vs one clip test and unchecked writes
+static void pixels_before(void) {
+    for (int i = 0; i < 64; i++) {
+        for (int arm = 0; arm < 4; arm++) {
+            int px = 64 + ((arm & 1) ? i : -i) / 2;
+            int py = 32 + ((arm & 2) ? i : -i) / 2;
+            if (px >= 0 && px < SSD1306_WIDTH && py >= 0 && py < SSD1306_HEIGHT) {
+                ssd1306_set_pixel(px, py, false);
+            }
+        }
+    }
+}
+static void pixels_after(void) {
+    if (!ssd1306_clip_contains(32, 0, 64, 64)) return;
+    for (int i = 0; i < 64; i++) {
+        for (int arm = 0; arm < 4; arm++) {
+            int px = 64 + ((arm & 1) ? i : -i) / 2;
+            int py = 32 + ((arm & 2) ? i : -i) / 2;
+            ssd1306_set_pixel_unchecked(px, py, false);
+        }
+    }
+}
+
+// ============================================================================
+// BITMAP BLITS
+// ============================================================================
+
+static const sprite_t bench_eye = {24, 20, SPRITE_EYE_NORMAL};
+
+// Old sprite_draw: unpack each bit and set it
+static void sprite_before(void) {
+    int bytes_per_row = (bench_eye.width + 7) / 8;
+    for (int row = 0; row < bench_eye.height; row++) {
+        for (int col = 0; col < bench_eye.width; col++) {
+            bool pixel = (bench_eye.data[row * bytes_per_row + col / 8] >> (7 - col % 8)) & 1;
+            ssd1306_set_pixel(30 + col, 13 + row, pixel);
+        }
+    }
+}
+static void sprite_after(void) { sprite_draw(&bench_eye, 30, 13, false); }
+
+// ============================================================================
+// PARTICLES
+// ============================================================================
+
+// A mix of effects, a quarter of the particles each: snow, confetti,
+// sparkles and tears, drawn black on white like the face overlays
+static const particle_emitter_config_t bench_effects[] = {
+    {   // Snow
+        .update = particle_kernel_drift, .shape = &particle_shape_dot, .rop = SSD1306_ROP_ANDNOT,
+        .spawn = {0, -4, SSD1306_WIDTH, 4}, .start = {0, 0, SSD1306_WIDTH, SSD1306_HEIGHT},
+        .vx_min = -PARTICLE_FX(0.25), .vx_max = PARTICLE_FX(0.25),
+        .vy_min = PARTICLE_FX(0.25), .vy_max = PARTICLE_FX(1.0), .margin = 2,
+    },
+    {   // Confetti
+        .update = particle_kernel_ballistic, .shape = &particle_shape_plus, .rop = SSD1306_ROP_ANDNOT,
+        .spawn = {60, 50, 8, 4},
+        .vx_min = -PARTICLE_FX(1.5), .vx_max = PARTICLE_FX(1.5),
+        .vy_min = -PARTICLE_FX(3.0), .vy_max = -PARTICLE_FX(1.5),
+        .gravity = PARTICLE_FX(0.1), .margin = 4,
+    },
+    {   // Sparkles
+        .update = particle_kernel_drift, .shape = &particle_shape_twinkle, .rop = SSD1306_ROP_ANDNOT,
+        .spawn = {0, 0, SSD1306_WIDTH, SSD1306_HEIGHT},
+        .rate_min = 8, .rate_max = 16, .life_min = 16, .life_max = 32,
+    },
+    {   // Tears
+        .update = particle_kernel_ballistic, .shape = &particle_shape_dot, .rop = SSD1306_ROP_ANDNOT,
+        .spawn = {30, 36, 4, 2},
+        .vx_min = -PARTICLE_FX(0.5), .vx_max = PARTICLE_FX(0.5),
+        .gravity = PARTICLE_FX(0.05), .margin = 2,
+    },
+};
+
+#define BENCH_EFFECTS  (int)(sizeof(bench_effects) / sizeof(bench_effects[0]))
+
+// Update and draw time per frame for count particles
+static void bench_particles(int count) {
+    particle_emitter_t *emitters[BENCH_EFFECTS];
+    bool ok = true;
+    for (int e = 0; e < BENCH_EFFECTS; e++) {
+        particle_emitter_config_t config = bench_effects[e];
+        config.count = count / BENCH_EFFECTS;
+        emitters[e] = particle_emitter_create(&config);
+        ok = ok && emitters[e];
+        particle_emitter_enable(emitters[e], true);
+    }
+    
+    if (ok) {
+        int64_t update_us = 0, draw_us = 0;
+        for (int i = 0; i < BENCH_FRAMES; i++) {
+            ssd1306_fill();
+            int64_t t0 = esp_timer_get_time();
+            particles_update();
+            int64_t t1 = esp_timer_get_time();
+            particles_draw();
+            update_us += t1 - t0;
+            draw_us += esp_timer_get_time() - t1;
+        }
+        ESP_LOGI(TAG, "particles %4d           update %4lu us, draw %5lu us per frame", count,
+                 (unsigned long)(update_us / BENCH_FRAMES), (unsigned long)(draw_us / BENCH_FRAMES));
+    } else {
+        ESP_LOGW(TAG, "particles %4d           no room in the pool", count);
+    }
+    
+    for (int e = 0; e < BENCH_EFFECTS; e++) particle_emitter_destroy(emitters[e]);
+}
+
+// ============================================================================
+// ENTRY POINTS
+// ============================================================================
+
+void bench_frame(const char *name, void (*draw)(void)) {
+    int64_t draw_us = 0, flush_us = 0;
+    
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        int64_t t0 = esp_timer_get_time();
+        draw();
+        int64_t t1 = esp_timer_get_time();
+        ssd1306_update();
+        draw_us += t1 - t0;
+        flush_us += esp_timer_get_time() - t1;
+    }
+    
+    ESP_LOGI(TAG, "%-22s draw %5lu us + flush %5lu us = %5lu us per frame (%s layout)", name,
+             (unsigned long)(draw_us / BENCH_FRAMES), (unsigned long)(flush_us / BENCH_FRAMES),
+             (unsigned long)((draw_us + flush_us) / BENCH_FRAMES),
+             SSD1306_ROW_MAJOR ? "row-major" : "page");
+}
+
+void bench_run_all(void) {
+    ESP_LOGI(TAG, "Running benchmarks (%d iterations each)", BENCH_ITERATIONS);
+    
+    bench_compare("fill_rect wink 44x38", wink_clear_before, wink_clear_after);
+    bench_compare("fill_rect blink 4x28x12", blink_cover_before, blink_cover_after);
+    bench_compare("hline 5x25", hline_before, hline_after);
+    bench_compare("fill_circle r10", circle_before, circle_after);
+    bench_compare("fill_ellipse 11x9", ellipse_before, ellipse_after);
+    bench_compare("ellipse dithered 11x9", ellipse_before, ellipse_dither_after);
+    bench_compare("sprite_draw 24x20", sprite_before, sprite_after);
+    bench_compare("set_pixel 256 px", pixels_before, pixels_after);
+    
+    for (int count = 64; count <= PARTICLE_MAX; count *= 2) bench_particles(count);
+    
+    ssd1306_clear();
+    
+    // Bus throughput per SCL rate; logged by the driver, rate left as is
+    ssd1306_bench_result_t bus;
+    ssd1306_benchmark(&bus, false);
+}
@@ -0,0 +1,35 @@
+/*
+ * Rendering Microbenchmarks
+ * Times drawing primitives against the per-pixel code they replaced
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * Run all benchmarks and log the results
+ * Draws into the SSD1306 frame buffer; clears it when done.
+ */
+void bench_run_all(void);
+
+/**
+ * Time two ways of drawing the same thing and log both and the speedup
+ * Each runs many times over into the SSD1306 frame buffer.
+ * @param name Label for the log
+ * @param before The reference (old) code
+ * @param after Its replacement
+ */
+void bench_compare(const char *name, void (*before)(void), void (*after)(void));
+
+/**
+ * Time drawing a whole frame and the ssd1306_update() after it
+ * Logs both averages and their sum for this build's frame buffer layout
+ * (SSD1306_ROW_MAJOR); build with it flipped for the other layout's
+ * figures. The frame repeats, so after the first one the flush cost is
+ * the layout conversion and shadow compare, not the bus.
+ * @param name Label for the log
+ * @param draw Draws one frame into the SSD1306 frame buffer
+ */
+void bench_frame(const char *name, void (*draw)(void));
+
+#endif // BENCH_H
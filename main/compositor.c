@@ -0,0 +1,240 @@
+/*
+ * Layer Compositor Implementation
+ * Two item lists, last frame's and this one's, are diffed by layer and
+ * id; the boxes that differ are merged into a few regions, and each
+ * region is cleared by repainting every item that reaches into it,
+ * clipped to the region
+ */
+
+#include "compositor.h"
+#include "ssd1306.h"
+#include <string.h>
+
+typedef struct {
+    compositor_draw_fn draw;
+    compositor_rect_t box;
+    uint16_t id;
+    uint8_t layer;
+    uint8_t len;
+    union {
+        uint8_t bytes[COMPOSITOR_ARG_BYTES];
+        void *align_ptr;
+        int32_t align_word;
+    } args;
+} item_t;
+
+typedef struct {
+    item_t items[COMPOSITOR_MAX_ITEMS];
+    int count;
+} item_list_t;
+
+static item_list_t lists[2];
+static item_list_t *cur = &lists[0];
+static item_list_t *prev = &lists[1];
+
+static compositor_rect_t dirty[COMPOSITOR_MAX_DIRTY];
+static int dirty_count = 0;
+
+static bool valid = false;          // prev is what the frame buffer holds
+static bool dropped = false;        // An item was dropped this frame
+
+static compositor_stats_t stats;
+
+// ============================================================================
+// RECTANGLES
+// ============================================================================
+
+static inline int area(const compositor_rect_t *r) {
+    return r->w * r->h;
+}
+
+// Overlapping or side by side
+static inline bool touches(const compositor_rect_t *a, const compositor_rect_t *b) {
+    return a->x <= b->x + b->w && b->x <= a->x + a->w &&
+           a->y <= b->y + b->h && b->y <= a->y + a->h;
+}
+
+static inline bool overlaps(const compositor_rect_t *a, const compositor_rect_t *b) {
+    return a->x < b->x + b->w && b->x < a->x + a->w &&
+           a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+static compositor_rect_t rect_union(const compositor_rect_t *a, const compositor_rect_t *b) {
+    int x0 = (a->x < b->x) ? a->x : b->x;
+    int y0 = (a->y < b->y) ? a->y : b->y;
+    int x1 = (a->x + a->w > b->x + b->w) ? a->x + a->w : b->x + b->w;
+    int y1 = (a->y + a->h > b->y + b->h) ? a->y + a->h : b->y + b->h;
+    return (compositor_rect_t){(int16_t)x0, (int16_t)y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+}
+
+// Add a region to repaint, merging it with any it touches. When the list
+// is full it goes into the one it grows least.
+static void add_dirty(compositor_rect_t r) {
+    int width = ssd1306_get_width();
+    int height = ssd1306_get_height();
+    int x0 = (r.x > 0) ? r.x : 0;
+    int y0 = (r.y > 0) ? r.y : 0;
+    int x1 = (r.x + r.w < width) ? r.x + r.w : width;
+    int y1 = (r.y + r.h < height) ? r.y + r.h : height;
+    if (x1 <= x0 || y1 <= y0) return;
+    r = (compositor_rect_t){(int16_t)x0, (int16_t)y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+
+    for (;;) {
+        int merge = -1;
+        for (int i = 0; i < dirty_count && merge < 0; i++) {
+            if (touches(&dirty[i], &r)) merge = i;
+        }
+        if (merge < 0 && dirty_count < COMPOSITOR_MAX_DIRTY) break;
+
+        if (merge < 0) {
+            int best_growth = 0;
+            for (int i = 0; i < dirty_count; i++) {
+                compositor_rect_t u = rect_union(&dirty[i], &r);
+                int growth = area(&u) - area(&dirty[i]);
+                if (merge < 0 || growth < best_growth) {
+                    merge = i;
+                    best_growth = growth;
+                }
+            }
+        }
+
+        // The union may reach others now, so place it again
+        r = rect_union(&dirty[merge], &r);
+        dirty[merge] = dirty[--dirty_count];
+    }
+    dirty[dirty_count++] = r;
+}
+
+// ============================================================================
+// DIFF AND REPAINT
+// ============================================================================
+
+static inline bool same_item(const item_t *a, const item_t *b) {
+    return a->draw == b->draw && a->len == b->len &&
+           a->box.x == b->box.x && a->box.y == b->box.y &&
+           a->box.w == b->box.w && a->box.h == b->box.h &&
+           memcmp(a->args.bytes, b->args.bytes, a->len) == 0;
+}
+
+// Queue the boxes of everything that differs from last frame
+static void diff_lists(void) {
+    bool matched[COMPOSITOR_MAX_ITEMS] = {false};
+
+    for (int k = 0; k < cur->count; k++) {
+        const item_t *c = &cur->items[k];
+
+        // Lists are usually built in the same order, so try the same slot
+        int found = -1;
+        if (k < prev->count && !matched[k] &&
+            prev->items[k].layer == c->layer && prev->items[k].id == c->id) {
+            found = k;
+        }
+        for (int j = 0; j < prev->count && found < 0; j++) {
+            if (!matched[j] && prev->items[j].layer == c->layer && prev->items[j].id == c->id) {
+                found = j;
+            }
+        }
+
+        if (found < 0) {
+            add_dirty(c->box);
+        } else {
+            matched[found] = true;
+            if (same_item(c, &prev->items[found])) continue;
+            add_dirty(prev->items[found].box);
+            add_dirty(c->box);
+        }
+        stats.changed[c->layer]++;
+    }
+
+    for (int j = 0; j < prev->count; j++) {
+        if (matched[j]) continue;
+        add_dirty(prev->items[j].box);
+        stats.changed[prev->items[j].layer]++;
+    }
+}
+
+// Redraw one region from all the items reaching into it
+static void repaint(const compositor_rect_t *r) {
+    if (!ssd1306_push_clip(r->x, r->y, r->w, r->h)) return;
+
+    for (int layer = 0; layer < COMPOSITOR_LAYERS; layer++) {
+        for (int k = 0; k < cur->count; k++) {
+            const item_t *it = &cur->items[k];
+            if (it->layer != layer || !overlaps(&it->box, r)) continue;
+            if (!ssd1306_push_clip(it->box.x, it->box.y, it->box.w, it->box.h)) continue;
+            it->draw(it->args.bytes);
+            ssd1306_pop_clip();
+            stats.draws++;
+        }
+    }
+
+    ssd1306_pop_clip();
+    stats.rects++;
+    stats.pixels += area(r);
+}
+
+// ============================================================================
+// FRAMES
+// ============================================================================
+
+void compositor_begin(void) {
+    cur->count = 0;
+    dropped = false;
+}
+
+bool compositor_add(uint8_t layer, uint16_t id, int x, int y, int w, int h,
+                    compositor_draw_fn draw, const void *args, size_t len) {
+    if (cur->count >= COMPOSITOR_MAX_ITEMS || len > COMPOSITOR_ARG_BYTES ||
+        layer >= COMPOSITOR_LAYERS || !draw) {
+        stats.dropped++;
+        dropped = true;
+        return false;
+    }
+    if (w <= 0 || h <= 0) return true;     // Draws nothing
+
+    item_t *it = &cur->items[cur->count++];
+    it->draw = draw;
+    it->box = (compositor_rect_t){(int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h};
+    it->id = id;
+    it->layer = layer;
+    it->len = (uint8_t)len;
+    memset(it->args.bytes, 0, sizeof(it->args.bytes));
+    if (len) memcpy(it->args.bytes, args, len);
+    return true;
+}
+
+void compositor_end(void) {
+    dirty_count = 0;
+    stats.frames++;
+
+    compositor_rect_t screen = {0, 0, (int16_t)ssd1306_get_width(), (int16_t)ssd1306_get_height()};
+    if (valid) diff_lists();
+
+    // Past half the screen, one pass over all of it draws each item once
+    // instead of once per region it reaches
+    int dirty_area = 0;
+    for (int i = 0; i < dirty_count; i++) dirty_area += area(&dirty[i]);
+    if (!valid || dirty_area * 2 > area(&screen)) {
+        dirty_count = 0;
+        add_dirty(screen);
+        stats.full++;
+    }
+    if (dirty_count == 0) stats.unchanged++;
+
+    for (int i = 0; i < dirty_count; i++) repaint(&dirty[i]);
+
+    // A dropped item may come back with nothing to diff against
+    valid = !dropped;
+
+    item_list_t *t = prev;
+    prev = cur;
+    cur = t;
+}
+
+void compositor_invalidate(void) {
+    valid = false;
+}
+
+void compositor_get_stats(compositor_stats_t *out) {
+    if (out) *out = stats;
+}
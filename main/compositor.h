@@ -0,0 +1,108 @@
+/*
+ * Layer Compositor
+ * Frames are described as a list of items, each a draw call with its
+ * arguments, a bounding box and a stable id on one of a few layers.
+ * Items that match last frame's are left as they are in the frame
+ * buffer; only the boxes of items that moved, changed, appeared or went
+ * away are cleared and redrawn from every item under them. Pages the
+ * repaint doesn't reach are never marked dirty, so the flush skips them.
+ */
+
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// BUILD CONFIGURATION
+// ============================================================================
+
+// Items per frame
+#ifndef COMPOSITOR_MAX_ITEMS
+#define COMPOSITOR_MAX_ITEMS  64
+#endif
+
+// Layers, drawn from 0 (bottom) up
+#ifndef COMPOSITOR_LAYERS
+#define COMPOSITOR_LAYERS  4
+#endif
+
+// Separate regions repainted per frame; beyond this, the closest ones are
+// merged
+#ifndef COMPOSITOR_MAX_DIRTY
+#define COMPOSITOR_MAX_DIRTY  8
+#endif
+
+// Largest argument block an item can carry
+#define COMPOSITOR_ARG_BYTES  16
+
+// ============================================================================
+// TYPES
+// ============================================================================
+
+/**
+ * Item draw call
+ * Gets a copy of the arguments given to compositor_add(). Runs with the
+ * clip set to the item's box (intersected with the region being
+ * repainted) and must draw the same pixels for the same arguments.
+ */
+typedef void (*compositor_draw_fn)(const void *args);
+
+typedef struct {
+    int16_t x, y, w, h;
+} compositor_rect_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t full;                  // Frames repainted whole
+    uint32_t unchanged;             // Frames with nothing to repaint
+    uint32_t rects;                 // Regions repainted
+    uint32_t pixels;                // Area of those regions
+    uint32_t draws;                 // Item draw calls
+    uint32_t dropped;               // Items that didn't fit in the list
+    uint32_t changed[COMPOSITOR_LAYERS];    // Items that moved, changed,
+                                            // appeared or went away
+} compositor_stats_t;
+
+// ============================================================================
+// FRAMES
+// ============================================================================
+
+/**
+ * Start describing a frame
+ */
+void compositor_begin(void);
+
+/**
+ * Add an item to the frame
+ * Items draw in layer order, then in the order they were added. Items
+ * match last frame's by layer and id; the arguments are copied and
+ * compared byte for byte, so argument structs should have no padding.
+ * @param box Everything the item draws lies inside it
+ * @param args Argument block, or NULL (len 0)
+ * @return false if the list is full or len is too big (item dropped)
+ */
+bool compositor_add(uint8_t layer, uint16_t id, int x, int y, int w, int h,
+                    compositor_draw_fn draw, const void *args, size_t len);
+
+/**
+ * Repaint what changed since the last frame into the frame buffer
+ * The caller presents it as usual.
+ */
+void compositor_end(void);
+
+/**
+ * Repaint the whole frame next time
+ * Call after drawing anything into the frame buffer outside the
+ * compositor, or changing how items draw (e.g. gray mode).
+ */
+void compositor_invalidate(void);
+
+/**
+ * Get counters since boot
+ */
+void compositor_get_stats(compositor_stats_t *stats);
+
+#endif // COMPOSITOR_H
@@ -12,8 +12,16 @@
 #include "esp_log.h"
 #include "esp_random.h"
 #include "ssd1306.h"
+#include "display.h"
 #include "render3d.h"
 #include "buzzer.h"
+#include "bench.h"
+#include "framestream.h"
+#include "particles.h"
+#include "compositor.h"
+#if SSD1306_HOST_BUS
+#include "ssd1306_hostbus.h"
+#endif
 
 static const char *TAG = "desktoy";
 
@@ -27,6 +35,98 @@ static const char *TAG = "desktoy";
 #define OLED_I2C_ADDR   0x3C
 #define BUZZER_PIN      3
 
+// Where frames go: display_backend_ssd1306, display_backend_null (render
+// only) or display_backend_host (files / pipe, see display.h)
+#ifndef DISPLAY_BACKEND
+#define DISPLAY_BACKEND  display_backend_ssd1306
+#endif
+
+#ifndef DISPLAY_HOST_PATH
+#define DISPLAY_HOST_PATH  "desktoy.gray"
+#endif
+
+// How the panel is mounted in the enclosure: SSD1306_ROT_0 or
+// SSD1306_ROT_180, optionally mirrored. The face is laid out for
+// landscape, so the portrait rotations don't apply here.
+#ifndef DISPLAY_ORIENTATION
+#define DISPLAY_ORIENTATION  SSD1306_ROT_0
+#endif
+
+#ifndef DISPLAY_MIRROR
+#define DISPLAY_MIRROR  0
+#endif
+
+static const display_config_t display_config = {
+    .sda_pin = I2C_SDA_PIN,
+    .scl_pin = I2C_SCL_PIN,
+    .i2c_addr = OLED_I2C_ADDR,
+    .host_mode = DISPLAY_HOST_RAW,
+    .host_path = DISPLAY_HOST_PATH,
+};
+
+// Set to 1 to move the face for bounce/tilt with the panel's start line
+// instead of redrawing it. Overlays then move with the face, and content
+// within the shift distance of the top or bottom edge is cut off. Only
+// the SSD1306 backend applies the shift; others redraw the face as usual.
+#ifndef HW_VERTICAL_SHIFT
+#define HW_VERTICAL_SHIFT  0
+#endif
+
+// Set to 1 to scroll "HAPPY BIRTHDAY" along the bottom of the screen with
+// the panel's hardware scroll instead of drawing it every frame. The panel
+// takes no display RAM writes while it scrolls, so the face holds still
+// until the birthday ends.
+#ifndef BIRTHDAY_MARQUEE
+#define BIRTHDAY_MARQUEE  0
+#endif
+
+// Set to 1 to shade the irises and eyebrows with the panel's 4-level
+// grayscale mode instead of dither patterns. Costs bus bandwidth (the
+// planes are resent continuously) and can flicker on some panels; only
+// the SSD1306 backend has it.
+#ifndef GRAYSCALE_EYES
+#define GRAYSCALE_EYES  0
+#endif
+
+// Set to 1 to time the I2C bus at boot and switch to the fastest SCL rate
+// the panel handles reliably (above its 400 kHz spec on many modules)
+#ifndef I2C_AUTOTUNE
+#define I2C_AUTOTUNE  0
+#endif
+
+// Set to 1 to stream what the panel shows, for watching a unit in the
+// field with tools/framestream_decode: out of UART1 on FRAME_STREAM_TX_PIN,
+// or into FRAME_STREAM_PATH (a file or FIFO) on host builds
+#ifndef FRAME_STREAM
+#define FRAME_STREAM  0
+#endif
+
+#define FRAME_STREAM_UART     1
+#define FRAME_STREAM_TX_PIN   4
+#define FRAME_STREAM_BAUD     921600
+
+#ifndef FRAME_STREAM_PATH
+#define FRAME_STREAM_PATH  "desktoy.fs"
+#endif
+
+// RAM for pre-rendered eye bitmaps, reused while the eyes hold still
+// (about 650 bytes per eye state; 0 draws them every frame)
+#ifndef EYE_CACHE_BYTES
+#define EYE_CACHE_BYTES  8192
+#endif
+
+// Redraw only the parts of the face that changed since the last frame,
+// so the flush only looks at the pages they touch (see compositor.h).
+// 0 repaints every frame whole.
+#ifndef PARTIAL_REDRAW
+#define PARTIAL_REDRAW  1
+#endif
+
+// Set to 1 to log rendering and bus benchmarks once at boot
+#ifndef RUN_BENCHMARKS
+#define RUN_BENCHMARKS  0
+#endif
+
 // Emotion types
 typedef enum {
     EMO_NORMAL = 0,
@@ -111,77 +211,29 @@ static void draw_splash_screen(const char *text) {
         char c = text[i];
         
         if (c == 'K') {
-            for (int y = 0; y < char_h; y++) {
-                for (int x = 0; x < 4; x++) {
-                    ssd1306_set_pixel(cx + x, start_y + y, false);
-                }
-            }
-            for (int d = 0; d < char_h/2; d++) {
-                for (int t = 0; t < 4; t++) {
-                    ssd1306_set_pixel(cx + 4 + d * 2/3 + t, start_y + char_h/2 - d, false);
-                }
-            }
+            ssd1306_fill_rect(cx, start_y, 4, char_h, false);
             for (int d = 0; d < char_h/2; d++) {
-                for (int t = 0; t < 4; t++) {
-                    ssd1306_set_pixel(cx + 4 + d * 2/3 + t, start_y + char_h/2 + d, false);
-                }
+                ssd1306_hline(cx + 4 + d * 2/3, start_y + char_h/2 - d, 4, false);
+                ssd1306_hline(cx + 4 + d * 2/3, start_y + char_h/2 + d, 4, false);
             }
         } else if (c == 'R') {
-            for (int y = 0; y < char_h; y++) {
-                for (int x = 0; x < 4; x++) {
-                    ssd1306_set_pixel(cx + x, start_y + y, false);
-                }
-            }
-            for (int x = 0; x < char_w - 2; x++) {
-                for (int y = 0; y < 4; y++) {
-                    ssd1306_set_pixel(cx + x, start_y + y, false);
-                }
-            }
-            for (int x = 0; x < char_w - 4; x++) {
-                for (int y = 0; y < 4; y++) {
-                    ssd1306_set_pixel(cx + x, start_y + char_h/2 - 2 + y, false);
-                }
-            }
-            for (int y = 0; y < char_h/2; y++) {
-                for (int x = 0; x < 4; x++) {
-                    ssd1306_set_pixel(cx + char_w - 4 + x, start_y + y, false);
-                }
-            }
+            ssd1306_fill_rect(cx, start_y, 4, char_h, false);
+            ssd1306_fill_rect(cx, start_y, char_w - 2, 4, false);
+            ssd1306_fill_rect(cx, start_y + char_h/2 - 2, char_w - 4, 4, false);
+            ssd1306_fill_rect(cx + char_w - 4, start_y, 4, char_h/2, false);
             for (int d = 0; d < char_h/2; d++) {
-                for (int t = 0; t < 4; t++) {
-                    ssd1306_set_pixel(cx + 4 + d * 2/3 + t, start_y + char_h/2 + d, false);
-                }
+                ssd1306_hline(cx + 4 + d * 2/3, start_y + char_h/2 + d, 4, false);
             }
         } else if (c == 'G') {
-            for (int x = 2; x < char_w; x++) {
-                for (int y = 0; y < 4; y++) {
-                    ssd1306_set_pixel(cx + x, start_y + y, false);
-                }
-            }
-            for (int x = 2; x < char_w; x++) {
-                for (int y = 0; y < 4; y++) {
-                    ssd1306_set_pixel(cx + x, start_y + char_h - 4 + y, false);
-                }
-            }
-            for (int y = 0; y < char_h; y++) {
-                for (int x = 0; x < 4; x++) {
-                    ssd1306_set_pixel(cx + x, start_y + y, false);
-                }
-            }
-            for (int y = char_h/2; y < char_h; y++) {
-                for (int x = 0; x < 4; x++) {
-                    ssd1306_set_pixel(cx + char_w - 4 + x, start_y + y, false);
-                }
-            }
-            for (int x = char_w/2; x < char_w; x++) {
-                for (int y = 0; y < 4; y++) {
-                    ssd1306_set_pixel(cx + x, start_y + char_h/2 - 2 + y, false);
-                }
-            }
+            ssd1306_fill_rect(cx + 2, start_y, char_w - 2, 4, false);
+            ssd1306_fill_rect(cx + 2, start_y + char_h - 4, char_w - 2, 4, false);
+            ssd1306_fill_rect(cx, start_y, 4, char_h, false);
+            ssd1306_fill_rect(cx + char_w - 4, start_y + char_h/2, 4, char_h - char_h/2, false);
+            ssd1306_fill_rect(cx + char_w/2, start_y + char_h/2 - 2, char_w - char_w/2, 4, false);
         }
     }
     
-    ssd1306_update();
+    display_present();
 }
 
 // ============================================================================
@@ -490,6 +542,16 @@ static render_ctx_t render_ctx;
 static float head_rotation = 0;
 static float head_tilt = 0;
 
+// Vertical bounce/tilt of the face: the part drawn into the frame and the
+// part applied by the panel (HW_VERTICAL_SHIFT)
+static int face_shift_y = 0;
+static int panel_shift_y = 0;
+
+// Only the SSD1306 backend has a start line to move
+static bool panel_shift_wanted(void) {
+    return HW_VERTICAL_SHIFT && display_get_backend() == &display_backend_ssd1306;
+}
+
 // Anime face parameters
 typedef struct {
     int x, y;
@@ -537,13 +599,155 @@ static void init_3d_scene(void) {
     right_eye = (anime_eye_t){.x = 96, .y = 26, .look_x = 0, .look_y = 0, .blink = 0};
 }
 
+// ============================================================================
+// HEART OUTLINES
+// ============================================================================
+
+// Hearts are traced from the parametric curve once per size, on first
+// use, into row spans around the center, so drawing one takes a few dozen
+// hlines and no trig
+
+typedef struct {
+    int8_t dy;
+    int8_t x;           // First column, relative to the center
+    uint8_t w;
+} heart_span_t;
+
+typedef struct {
+    const heart_span_t *spans;  // NULL until traced
+    uint8_t count;
+} heart_outline_t;
+
+#define HEART_TRACE_SIZE  48    // Trace area, centered on the heart
+
+// Trace a heart scale pixels across each half, one point per step of the
+// curve, optionally with a plus around each point. Returns the spans.
+static int heart_trace(heart_span_t *spans, int max_spans, float step, float scale, bool thick) {
+    static uint8_t area[HEART_TRACE_SIZE][HEART_TRACE_SIZE];
+    const int c = HEART_TRACE_SIZE / 2;
+    memset(area, 0, sizeof(area));
+    
+    for (float t = 0; t < 6.28f; t += step) {
+        float x = 16.0f * sinf(t) * sinf(t) * sinf(t);
+        float y = 13.0f * cosf(t) - 5.0f * cosf(2*t) - 2.0f * cosf(3*t) - cosf(4*t);
+        int px = c + (int)(x * scale / 16.0f);
+        int py = c - (int)(y * scale / 17.0f);
+        if (px < 1 || px >= HEART_TRACE_SIZE - 1 || py < 1 || py >= HEART_TRACE_SIZE - 1) continue;
+        
+        area[py][px] = 1;
+        if (thick) {
+            area[py][px + 1] = 1;
+            area[py + 1][px] = 1;
+            area[py][px - 1] = 1;
+            area[py - 1][px] = 1;
+        }
+    }
+    
+    int count = 0;
+    for (int y = 0; y < HEART_TRACE_SIZE; y++) {
+        for (int x = 0; x < HEART_TRACE_SIZE; x++) {
+            if (!area[y][x]) continue;
+            int start = x;
+            while (x < HEART_TRACE_SIZE && area[y][x]) x++;
+            if (count == max_spans) return count;
+            spans[count++] = (heart_span_t){(int8_t)(y - c), (int8_t)(start - c), (uint8_t)(x - start)};
+        }
+    }
+    return count;
+}
+
+static void heart_draw(const heart_outline_t *outline, int cx, int cy) {
+    for (int i = 0; i < outline->count; i++) {
+        const heart_span_t *s = &outline->spans[i];
+        ssd1306_hline(cx + s->x, cy + s->dy, s->w, false);
+    }
+}
+
+// Box around an outline, relative to its center
+static void heart_bounds(const heart_outline_t *outline, int *x0, int *y0, int *x1, int *y1) {
+    *x0 = *y0 = *x1 = *y1 = 0;
+    for (int i = 0; i < outline->count; i++) {
+        const heart_span_t *s = &outline->spans[i];
+        if (i == 0 || s->x < *x0) *x0 = s->x;
+        if (i == 0 || s->dy < *y0) *y0 = s->dy;
+        if (i == 0 || s->x + s->w > *x1) *x1 = s->x + s->w;
+        if (i == 0 || s->dy + 1 > *y1) *y1 = s->dy + 1;
+    }
+}
+
+// Love eyes: thick outlines, beating through LOVE_HEART_BEAT sizes above
+// LOVE_HEART_SIZE
+#define LOVE_HEART_SIZE       18
+#define LOVE_HEART_BEAT       3
+#define LOVE_HEART_MAX_SPANS  96
+
+static heart_span_t love_heart_spans[LOVE_HEART_BEAT + 1][LOVE_HEART_MAX_SPANS];
+static heart_outline_t love_hearts[LOVE_HEART_BEAT + 1];
+
+static const heart_outline_t *love_heart(int beat) {
+    heart_outline_t *outline = &love_hearts[beat];
+    if (!outline->spans) {
+        outline->count = heart_trace(love_heart_spans[beat], LOVE_HEART_MAX_SPANS, 0.06f,
+                                     (float)(LOVE_HEART_SIZE + beat), true);
+        outline->spans = love_heart_spans[beat];
+    }
+    return outline;
+}
+
+// Floating hearts: one pixel per point, sizes FLOATING_HEART_MIN..MAX
+#define FLOATING_HEART_MIN        14
+#define FLOATING_HEART_MAX        20
+#define FLOATING_HEART_MAX_SPANS  16
+
+static heart_span_t floating_heart_spans[FLOATING_HEART_MAX - FLOATING_HEART_MIN + 1][FLOATING_HEART_MAX_SPANS];
+static heart_outline_t floating_hearts[FLOATING_HEART_MAX - FLOATING_HEART_MIN + 1];
+
+static const heart_outline_t *floating_heart(int size) {
+    int i = size - FLOATING_HEART_MIN;
+    heart_outline_t *outline = &floating_hearts[i];
+    if (!outline->spans) {
+        // Scale based on desired size, fewer points for smaller hearts
+        outline->count = heart_trace(floating_heart_spans[i], FLOATING_HEART_MAX_SPANS, 0.15f,
+                                     size / 6.0f, false);
+        outline->spans = floating_heart_spans[i];
+    }
+    return outline;
+}
+
+#if RUN_BENCHMARKS
+// Baseline for the benchmarks: the curve evaluated and plotted point by
+// point, as every heart was each frame before the span tables
+static void heart_parametric(int cx, int cy, float step, float scale, bool thick) {
+    for (float t = 0; t < 6.28f; t += step) {
+        float x = 16.0f * sinf(t) * sinf(t) * sinf(t);
+        float y = 13.0f * cosf(t) - 5.0f * cosf(2*t) - 2.0f * cosf(3*t) - cosf(4*t);
+        int px = cx + (int)(x * scale / 16.0f);
+        int py = cy - (int)(y * scale / 17.0f);
+        
+        ssd1306_set_pixel(px, py, false);
+        if (thick) {
+            ssd1306_set_pixel(px + 1, py, false);
+            ssd1306_set_pixel(px, py + 1, false);
+            ssd1306_set_pixel(px - 1, py, false);
+            ssd1306_set_pixel(px, py - 1, false);
+        }
+    }
+}
+
+static void love_heart_before(void) { heart_parametric(32, 26, 0.06f, LOVE_HEART_SIZE, true); }
+static void love_heart_after(void)  { heart_draw(love_heart(0), 32, 26); }
+
+static void floating_heart_before(void) { heart_parametric(64, 32, 0.15f, 17 / 6.0f, false); }
+static void floating_heart_after(void)  { heart_draw(floating_heart(17), 64, 32); }
+#endif
+
 // ============================================================================
 // 2D DRAWING HELPERS (for eyes, eyebrows, effects)
 // ============================================================================
 
-// Draw a heart outline for love eyes (beating animation)
-static void draw_heart_2d(int cx, int cy, int base_size) {
-    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+// Love eye size step (see love_heart()) for the time: a quick beat, then
+// a rest
+static int love_heart_beat(uint32_t now) {
     float beat_phase = (float)(now % 600) / 600.0f;
     float beat;
     if (beat_phase < 0.15f) {
@@ -553,49 +757,147 @@ static void draw_heart_2d(int cx, int cy, int base_size) {
     } else {
         beat = 0;
     }
-    float size = base_size + beat * 3.0f;
+    
+    // Grown by the nearest whole pixel
+    return (int)(beat * LOVE_HEART_BEAT + 0.5f);
+}
 
-    // Draw heart outline using parametric equation (thicker/darker)
-    for (float t = 0; t < 6.28f; t += 0.06f) {
-        float x = 16.0f * sinf(t) * sinf(t) * sinf(t);
-        float y = 13.0f * cosf(t) - 5.0f * cosf(2*t) - 2.0f * cosf(3*t) - cosf(4*t);
-        int px = cx + (int)(x * size / 16.0f);
-        int py = cy - (int)(y * size / 17.0f);
 
-        // Draw thicker outline by setting multiple pixels around each point
-        ssd1306_set_pixel(px, py, false);
-        ssd1306_set_pixel(px + 1, py, false);
-        ssd1306_set_pixel(px, py + 1, false);
-        ssd1306_set_pixel(px - 1, py, false);
-        ssd1306_set_pixel(px, py - 1, false);
+// Iris gradient: dark at the top, dithered through three gray levels,
+// white at the bottom. Patterns are 8-pixel bytes for ssd1306_hline_pattern.
+typedef struct {
+    int cx, cy, h;
+} iris_gradient_t;
+
+static uint8_t iris_gradient_row(int y, void *user) {
+    const iris_gradient_t *g = user;
+    int dy = y - g->cy;
+    int level = (dy + g->h) * 2 / g->h;   // 0..4 down the iris
+    bool odd_row = ((dy - g->cx) & 1) != 0;
+    
+    switch (level) {
+        case 0:  return 0x00;
+        case 1:  return odd_row ? 0x55 : 0xAA;  // (dx + dy) odd
+        case 2:  return odd_row ? 0xAA : 0x55;  // (dx + dy) even
+        case 3:  return (dy & 1) ? 0x00 : ((g->cx & 1) ? 0xAA : 0x55);  // dx, dy even
+        default: return 0xFF;
     }
 }
 
-
-// Draw anime-style eye
-static void draw_anime_eye_2d(int cx, int cy, int look_x, int look_y, float openness, 
-                               bool is_left, emotion_t emo) {
-    int eye_w = 40;
-    int eye_h = 34;
-    int half_w = eye_w / 2;
-    int half_h = eye_h / 2;
+// Same bands in true gray, one clipped ellipse per level
+static void draw_iris_gray(int cx, int cy, int w, int h) {
+    static const uint8_t band_gray[5] = {
+        SSD1306_GRAY_BLACK, SSD1306_GRAY_DARK, SSD1306_GRAY_DARK,
+        SSD1306_GRAY_LIGHT, SSD1306_GRAY_WHITE,
+    };
     
-    if (face.shake > 0 && face.emotion != EMO_CRAZY) {
-        cx += (int)(face.shake * ((esp_random() % 5) - 2));
+    for (int level = 0; level < 5; level++) {
+        // Rows where (dy + h) * 2 / h == level
+        int y0 = cy - h + (level * h + 1) / 2;
+        int y1 = (level == 4) ? cy + h + 1 : cy - h + ((level + 1) * h + 1) / 2;
+        if (y1 <= y0) continue;
+        if (!ssd1306_push_clip(cx - w, y0, 2 * w + 1, y1 - y0)) break;
+        ssd1306_fill_ellipse_gray(cx, cy, w, h, band_gray[level]);
+        ssd1306_pop_clip();
+    }
+}
+
+// Eye shapes, picked from the openness thresholds
+typedef enum {
+    EYE_SHAPE_CLOSED = 0,   // Curved line
+    EYE_SHAPE_SQUINT,       // Trollface's downturned squint
+    EYE_SHAPE_OPEN,
+} eye_shape_t;
+
+// Everything an eye's pixels depend on besides its position. Openness is
+// reduced to the whole-pixel sizes it draws with, and fields a shape
+// doesn't use are zero, so nearby states share one key.
+typedef struct {
+    uint8_t shape;          // eye_shape_t
+    uint8_t emotion;        // Only where the shape uses it
+    uint8_t is_left;
+    int8_t look_x, look_y;
+    uint8_t half_h;         // Outline half height
+    uint8_t iris_h;         // Iris vertical radius
+    uint8_t phase;          // cy & 7, set by the cache
+} eye_key_t;
+
+#define EYE_W  40
+#define EYE_H  34
+
+static void eye_key_make(eye_key_t *key, int look_x, int look_y, float openness,
+                         bool is_left, emotion_t emo) {
+    memset(key, 0, sizeof(*key));
+    if (openness < 0.2f) {
+        key->shape = EYE_SHAPE_CLOSED;
+        key->emotion = (emo == EMO_HAPPY || emo == EMO_LAUGHING) ? emo : EMO_NORMAL;
+        return;
+    }
+    if (emo == EMO_TROLLFACE && openness < 0.8f) {
+        key->shape = EYE_SHAPE_SQUINT;
+        key->is_left = is_left;
+        return;
     }
     
-    if (emo == EMO_LOVE && openness > 0.3f) {
-        draw_heart_2d(cx, cy, 18);
+    int visible_h = (int)(EYE_H * openness);
+    if (visible_h < 8) visible_h = 8;
+    int iris_h = (int)(9 * openness);
+    if (iris_h < 5) iris_h = 5;
+    
+    key->shape = EYE_SHAPE_OPEN;
+    key->emotion = (emo == EMO_SURPRISED || emo == EMO_WINK) ? emo : EMO_NORMAL;
+    key->is_left = is_left;
+    key->look_x = (int8_t)look_x;
+    key->look_y = (int8_t)look_y;
+    key->half_h = (emo == EMO_SURPRISED) ? EYE_H / 2 + 3 : visible_h / 2;
+    key->iris_h = (uint8_t)iris_h;
+}
+
+// Box around the pixels an eye touches, relative to its center
+static void eye_key_bounds(const eye_key_t *key, int *x0, int *y0, int *x1, int *y1) {
+    int half_w = EYE_W / 2;
+    *x0 = -half_w;
+    *x1 = half_w + 1;
+    
+    if (key->shape == EYE_SHAPE_CLOSED) {
+        *y0 = 0;
+        *y1 = 6;
+        return;
+    }
+    if (key->shape == EYE_SHAPE_SQUINT) {
+        *y0 = -1;
+        *y1 = 12;
         return;
     }
     
-    // Crazy eyes use normal eyes but with bloodshot effect
+    // Outline, then the iris, pupil and highlight, which can spill past it
+    // (the pupil and highlight reach 6 rows above and below the iris center)
+    int iris_cy = key->look_y + 1;
+    int iris_r = (key->iris_h > 6) ? key->iris_h : 6;
+    if (key->look_x - 11 < *x0) *x0 = key->look_x - 11;
+    if (key->look_x + 12 > *x1) *x1 = key->look_x + 12;
+    *y0 = (iris_cy - iris_r < -key->half_h) ? iris_cy - iris_r : -key->half_h;
+    *y1 = (iris_cy + iris_r + 1 > key->half_h - 1) ? iris_cy + iris_r + 1 : key->half_h - 1;
     
+    // Wink clears a box over the whole eye
+    if (key->emotion == EMO_WINK && !key->is_left) {
+        if (-half_w - 2 < *x0) *x0 = -half_w - 2;
+        if (half_w + 2 > *x1) *x1 = half_w + 2;
+        if (-EYE_H / 2 - 2 < *y0) *y0 = -EYE_H / 2 - 2;
+        if (EYE_H / 2 + 2 > *y1) *y1 = EYE_H / 2 + 2;
+    }
+}
+
+// Draw an eye from its key
+static void render_anime_eye(int cx, int cy, const eye_key_t *key) {
+    int half_w = EYE_W / 2;
+    int half_h = EYE_H / 2;
+    bool is_left = key->is_left;
     
-    if (openness < 0.2f) {
+    if (key->shape == EYE_SHAPE_CLOSED) {
         for (int x = -half_w; x <= half_w; x++) {
             float t = (float)x / (float)half_w;
-            int curve = (emo == EMO_HAPPY || emo == EMO_LAUGHING) ? 4 : 2;
+            int curve = (key->emotion == EMO_HAPPY || key->emotion == EMO_LAUGHING) ? 4 : 2;
             int y = (int)(t * t * curve);
             ssd1306_set_pixel(cx + x, cy + y, false);
             ssd1306_set_pixel(cx + x, cy + y + 1, false);
@@ -604,7 +906,7 @@ static void draw_anime_eye_2d(int cx, int cy, int look_x, int look_y, float open
     }
     
     // Trollface gets special squinty downturned eyes (opposite of the smile)
-    if (emo == EMO_TROLLFACE && openness < 0.8f) {
+    if (key->shape == EYE_SHAPE_SQUINT) {
         // Draw the downturned squinty eye - curves downward opposite to the crooked smile
         for (int x = -half_w; x <= half_w; x++) {
             float t = (float)x / (float)half_w;
@@ -622,13 +924,7 @@ static void draw_anime_eye_2d(int cx, int cy, int look_x, int look_y, float open
         return;
     }
     
-    int visible_h = (int)(eye_h * openness);
-    if (visible_h < 8) visible_h = 8;
-    int adj_half_h = visible_h / 2;
-    
-    if (emo == EMO_SURPRISED) {
-        adj_half_h = half_h + 3;
-    }
+    int adj_half_h = key->half_h;
     
     for (int x = -half_w; x <= half_w; x++) {
         float t = (float)x / (float)half_w;
@@ -652,42 +948,22 @@ static void draw_anime_eye_2d(int cx, int cy, int look_x, int look_y, float open
         ssd1306_set_pixel(cx + right_x, cy + y, false);
     }
     
-    int iris_cx = cx + look_x;
-    int iris_cy = cy + look_y + 1;
+    int iris_cx = cx + key->look_x;
+    int iris_cy = cy + key->look_y + 1;
     int iris_w = 11;
-    int iris_h = (int)(9 * openness);
-    if (iris_h < 5) iris_h = 5;
+    int iris_h = key->iris_h;
     
-    for (int dy = -iris_h; dy <= iris_h; dy++) {
-        for (int dx = -iris_w; dx <= iris_w; dx++) {
-            float ex = (float)dx / iris_w;
-            float ey = (float)dy / iris_h;
-            if (ex*ex + ey*ey <= 1.0f) {
-                float gradient = (float)(dy + iris_h) / (float)(2 * iris_h);
-                int threshold = (int)(gradient * 4);
-                bool pixel;
-                if (threshold == 0) pixel = false;
-                else if (threshold == 1) pixel = ((dx + dy) % 2 != 0);
-                else if (threshold == 2) pixel = ((dx + dy) % 2 == 0);
-                else if (threshold == 3) pixel = ((dx % 2 == 0) && (dy % 2 == 0));
-                else pixel = true;
-                ssd1306_set_pixel(iris_cx + dx, iris_cy + dy, pixel);
-            }
-        }
+    if (ssd1306_get_gray_mode()) {
+        draw_iris_gray(iris_cx, iris_cy, iris_w, iris_h);
+    } else {
+        iris_gradient_t gradient = {.cx = iris_cx, .cy = iris_cy, .h = iris_h};
+        ssd1306_fill_ellipse_pattern(iris_cx, iris_cy, iris_w, iris_h, iris_gradient_row, &gradient);
     }
     
     // Draw pupil (normal for all emotions)
-    int pupil_w = (emo == EMO_SURPRISED) ? 2 : 4;
-    int pupil_h = (emo == EMO_SURPRISED) ? 3 : 6;
-    for (int dy = -pupil_h; dy <= pupil_h; dy++) {
-        for (int dx = -pupil_w; dx <= pupil_w; dx++) {
-            float ex = (float)dx / pupil_w;
-            float ey = (float)dy / pupil_h;
-            if (ex*ex + ey*ey <= 1.0f) {
-                ssd1306_set_pixel(iris_cx + dx, iris_cy + dy, false);
-            }
-        }
-    }
+    int pupil_w = (key->emotion == EMO_SURPRISED) ? 2 : 4;
+    int pupil_h = (key->emotion == EMO_SURPRISED) ? 3 : 6;
+    ssd1306_fill_ellipse(iris_cx, iris_cy, pupil_w, pupil_h, false);
 
     int hl_x = iris_cx - 5;
     int hl_y = iris_cy - 4;
@@ -701,8 +977,8 @@ static void draw_anime_eye_2d(int cx, int cy, int look_x, int look_y, float open
     ssd1306_set_pixel(iris_cx + 4, iris_cy + 3, true);
     ssd1306_set_pixel(iris_cx + 5, iris_cy + 3, true);
     
-    if (emo == EMO_WINK && !is_left) {
-        ssd1306_fill_rect(cx - half_w - 2, cy - half_h - 2, eye_w + 4, eye_h + 4, true);
+    if (key->emotion == EMO_WINK && !is_left) {
+        ssd1306_fill_rect(cx - half_w - 2, cy - half_h - 2, EYE_W + 4, EYE_H + 4, true);
         for (int x = -half_w; x <= half_w; x++) {
             float t = (float)x / (float)half_w;
             int y = (int)(t * t * 4);
@@ -712,10 +988,176 @@ static void draw_anime_eye_2d(int cx, int cy, int look_x, int look_y, float open
     }
 }
 
+// ============================================================================
+// EYE CACHE
+// ============================================================================
+
+// An eye only ever sets pixels, so it is stored as two page-packed masks:
+// pixels it turns off (ink) and pixels it turns on (light). A hit clears
+// the ink and sets the light, leaving the brows and mouth beneath as they
+// were. Bitmaps start on a page boundary of the screen, so both blits
+// write whole bytes.
+
+#define EYE_CACHE_MAX_W      52
+#define EYE_CACHE_MAX_PAGES  6
+
+typedef struct {
+    eye_key_t key;
+    bool used;
+    bool has_light;
+    int8_t x0, top;             // Bitmap corner relative to the eye center
+    uint8_t width, height;
+    uint32_t last_used;
+    uint8_t ink[EYE_CACHE_MAX_PAGES * EYE_CACHE_MAX_W];
+    uint8_t light[EYE_CACHE_MAX_PAGES * EYE_CACHE_MAX_W];
+} eye_cache_entry_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t uncached;          // Drawn directly: gray mode, clipped or too big
+    uint32_t evictions;
+} eye_cache_stats_t;
+
+#define EYE_CACHE_SLOTS  (EYE_CACHE_BYTES / sizeof(eye_cache_entry_t))
+
+static eye_cache_stats_t eye_cache_stats;
+
+#if EYE_CACHE_BYTES
+static eye_cache_entry_t eye_cache[EYE_CACHE_SLOTS > 0 ? EYE_CACHE_SLOTS : 1];
+static uint32_t eye_cache_clock = 0;
+
+// Copy a screen rectangle into page-packed bitmap data
+static void eye_cache_capture(int x, int y, int w, int h, uint8_t *out) {
+    memset(out, 0, ((h + 7) / 8) * w);
+    for (int r = 0; r < h; r++) {
+        for (int c = 0; c < w; c++) {
+            if (ssd1306_get_pixel(x + c, y + r)) out[(r / 8) * w + c] |= 1 << (r % 8);
+        }
+    }
+}
+
+// Render an eye twice in place, over white and over black, to get its
+// masks, then put back what was under it
+static void eye_cache_fill(eye_cache_entry_t *entry, int cx, int cy, int x, int y) {
+    static uint8_t under[EYE_CACHE_MAX_PAGES * EYE_CACHE_MAX_W];
+    int w = entry->width, h = entry->height;
+    int bytes = ((h + 7) / 8) * w;
+    
+    eye_cache_capture(x, y, w, h, under);
+    ssd1306_push_clip(x, y, w, h);
+    
+    ssd1306_fill_rect(x, y, w, h, true);
+    render_anime_eye(cx, cy, &entry->key);
+    eye_cache_capture(x, y, w, h, entry->ink);
+    for (int i = 0; i < bytes; i++) entry->ink[i] = ~entry->ink[i];
+    
+    ssd1306_fill_rect(x, y, w, h, false);
+    render_anime_eye(cx, cy, &entry->key);
+    eye_cache_capture(x, y, w, h, entry->light);
+    entry->has_light = false;
+    for (int i = 0; i < bytes && !entry->has_light; i++) entry->has_light = entry->light[i] != 0;
+    
+    bitmap_t saved = {w, h, under};
+    ssd1306_blit(&saved, x, y, SSD1306_ROP_COPY);
+    ssd1306_pop_clip();
+}
+
+// Draw an eye from the cache, rendering it into a slot on a miss.
+// Returns false if it can't be cached here; the caller draws it.
+static bool eye_cache_draw(int cx, int cy, eye_key_t *key) {
+    key->phase = cy & 7;
+    
+    int x0, y0, x1, y1;
+    eye_key_bounds(key, &x0, &y0, &x1, &y1);
+    int top = y0 - ((cy + y0) & 7);         // Round down to a page boundary
+    int width = x1 - x0;
+    int height = y1 - top;
+    if (width > EYE_CACHE_MAX_W || height > EYE_CACHE_MAX_PAGES * 8) return false;
+    
+    // Masks are taken with the whole box drawable. An eye partly off the
+    // side is rendered further in: its pixels (the iris dither included)
+    // depend only on the offset from its center.
+    int x = cx + x0;
+    int y = cy + top;
+    int fill_x = x;
+    if (fill_x < 0) fill_x = 0;
+    if (fill_x + width > SCREEN_WIDTH) fill_x = SCREEN_WIDTH - width;
+    if (!ssd1306_clip_contains(fill_x, y, width, height)) return false;
+    
+    eye_cache_entry_t *entry = NULL;
+    eye_cache_entry_t *victim = &eye_cache[0];
+    for (size_t i = 0; i < EYE_CACHE_SLOTS; i++) {
+        eye_cache_entry_t *e = &eye_cache[i];
+        if (e->used && memcmp(&e->key, key, sizeof(*key)) == 0) {
+            entry = e;
+            break;
+        }
+        if (victim->used && (!e->used || e->last_used < victim->last_used)) victim = e;
+    }
+    
+    if (entry) {
+        eye_cache_stats.hits++;
+    } else {
+        eye_cache_stats.misses++;
+        if (victim->used) eye_cache_stats.evictions++;
+        entry = victim;
+        entry->key = *key;
+        entry->used = true;
+        entry->x0 = (int8_t)x0;
+        entry->top = (int8_t)top;
+        entry->width = (uint8_t)width;
+        entry->height = (uint8_t)height;
+        eye_cache_fill(entry, cx + fill_x - x, cy, fill_x, y);
+    }
+    entry->last_used = ++eye_cache_clock;
+    
+    bitmap_t ink = {entry->width, entry->height, entry->ink};
+    ssd1306_blit(&ink, x, y, SSD1306_ROP_ANDNOT);
+    if (entry->has_light) {
+        bitmap_t light = {entry->width, entry->height, entry->light};
+        ssd1306_blit(&light, x, y, SSD1306_ROP_OR);
+    }
+    return true;
+}
+#endif
+
+// Draw anime-style eye
+static void draw_anime_eye_2d(int cx, int cy, const eye_key_t *key) {
+    eye_key_t k = *key;
+#if EYE_CACHE_BYTES
+    // Gray irises live in the second plane, which the masks don't cover
+    if (!ssd1306_get_gray_mode() && eye_cache_draw(cx, cy, &k)) return;
+#endif
+    eye_cache_stats.uncached++;
+    render_anime_eye(cx, cy, &k);
+}
+
+// Box an eye draws in: its bounds, rounded out to pages and widened to
+// where the cache renders it, so repainting the whole eye stays cacheable
+static void eye_box(int cx, int cy, const eye_key_t *key, int *x, int *y, int *w, int *h) {
+    int x0, y0, x1, y1;
+    eye_key_bounds(key, &x0, &y0, &x1, &y1);
+    int top = y0 - ((cy + y0) & 7);
+    int width = x1 - x0;
+    
+    int left = cx + x0;
+    int fill_x = left;
+    if (fill_x < 0) fill_x = 0;
+    if (fill_x + width > SCREEN_WIDTH) fill_x = SCREEN_WIDTH - width;
+    if (fill_x < left) left = fill_x;
+    
+    *x = left;
+    *y = cy + top;
+    *w = ((fill_x > cx + x0) ? fill_x : cx + x0) + width - left;
+    *h = y1 - top;
+}
+
 // Draw eyebrow
 static void draw_eyebrow_2d(int cx, int cy, bool is_left, float angle, float height_offset) {
     int brow_w = 28;  // Wider to match the big anime eyes
     int dir = is_left ? 1 : -1;
+    bool gray = ssd1306_get_gray_mode();
     
     cy += (int)height_offset;
     
@@ -735,7 +1177,11 @@ static void draw_eyebrow_2d(int cx, int cy, bool is_left, float angle, float hei
             if (row == 3 && (t < 0.15f || t > 0.85f)) draw_row = false;
             if (row == 4 && (t < 0.3f || t > 0.7f)) draw_row = false;
             
-            if (draw_row) {
+            if (draw_row && gray) {
+                // Same falloff in real gray: light edges, dark center
+                ssd1306_set_pixel_gray(x, y + row, (row == 2) ? SSD1306_GRAY_DARK
+                                                              : SSD1306_GRAY_LIGHT);
+            } else if (draw_row) {
                 // Dithering: checkerboard pattern makes it appear gray
                 // Outer rows more dithered (fainter), inner rows less dithered (darker)
                 bool dither;
@@ -764,10 +1210,10 @@ static void draw_zzz_2d(int x, int y) {
         int zx = x + i * 8;
         int zy = y - i * 4;
         int size = 4 + i;
+        ssd1306_hline(zx, zy, size, false);
+        ssd1306_hline(zx, zy + size - 1, size, false);
         for (int j = 0; j < size; j++) {
-            ssd1306_set_pixel(zx + j, zy, false);
             ssd1306_set_pixel(zx + size - j - 1, zy + j, false);
-            ssd1306_set_pixel(zx + j, zy + size - 1, false);
         }
     }
 }
@@ -786,22 +1232,15 @@ static void draw_teeth(int cx, int top_y, int bot_y, int width, int num_teeth) {
     // Top teeth (hang down from top)
     for (int t = 0; t < num_teeth; t++) {
         int tx = cx - width + t * tooth_gap + tooth_gap / 2;
-        for (int th = 0; th < tooth_height; th++) {
-            // Each tooth is a small rectangle
-            ssd1306_set_pixel(tx, top_y + th, true);
-            ssd1306_set_pixel(tx + 1, top_y + th, true);
-        }
+        // Each tooth is a small rectangle
+        ssd1306_fill_rect(tx, top_y, 2, tooth_height, true);
         // Tooth separator line
-        ssd1306_set_pixel(tx + 2, top_y, false);
-        ssd1306_set_pixel(tx + 2, top_y + 1, false);
+        ssd1306_vline(tx + 2, top_y, 2, false);
     }
 }
 
 // Draw mouth based on emotion - now with teeth and more expression!
 static void draw_mouth_2d(int cx, int cy, emotion_t emo) {
-    int bounce_y = (int)(face.bounce * 2);
-    cy += bounce_y;
-    
     switch (emo) {
         case EMO_NORMAL: {
             // Gentle closed mouth with slight curve
@@ -854,9 +1293,7 @@ static void draw_mouth_2d(int cx, int cy, emotion_t emo) {
             // Dark mouth interior
             for (int y = cy + 1; y < cy + 6; y++) {
                 int fill_w = width - 2 - (y - cy) / 2;
-                for (int x = -fill_w; x <= fill_w; x++) {
-                    ssd1306_set_pixel(cx + x, y, false);
-                }
+                ssd1306_hline(cx - fill_w, y, 2 * fill_w + 1, false);
             }
             break;
         }
@@ -909,19 +1346,14 @@ static void draw_mouth_2d(int cx, int cy, emotion_t emo) {
             // Dark inside
             for (int dy = -ry + 2; dy < ry - 2; dy++) {
                 int w = (int)(sqrtf(1.0f - (float)(dy * dy) / (ry * ry)) * (rx - 2));
-                for (int dx = -w; dx <= w; dx++) {
-                    ssd1306_set_pixel(cx + dx, cy + dy, false);
-                }
+                ssd1306_hline(cx - w, cy + dy, 2 * w + 1, false);
             }
             break;
         }
             
         case EMO_SLEEPY: {
             // Slightly open, relaxed
-            for (int x = -5; x <= 5; x++) {
-                ssd1306_set_pixel(cx + x, cy, false);
-                ssd1306_set_pixel(cx + x, cy + 1, false);
-            }
+            ssd1306_fill_rect(cx - 5, cy, 11, 2, false);
             break;
         }
         
@@ -976,10 +1408,8 @@ static void draw_mouth_2d(int cx, int cy, emotion_t emo) {
                 ssd1306_set_pixel(cx + x, cy + wave + 1, false);
             }
             // Small opening in center
-            for (int x = -3; x <= 3; x++) {
-                ssd1306_set_pixel(cx + x, cy - 1, false);
-                ssd1306_set_pixel(cx + x, cy + 3, false);
-            }
+            ssd1306_hline(cx - 3, cy - 1, 7, false);
+            ssd1306_hline(cx - 3, cy + 3, 7, false);
             break;
         }
             
@@ -1099,189 +1529,133 @@ static void draw_mouth_2d(int cx, int cy, emotion_t emo) {
             
         default: {
             // Fallback simple mouth
-            for (int x = -6; x <= 6; x++) {
-                ssd1306_set_pixel(cx + x, cy, false);
-            }
+            ssd1306_hline(cx - 6, cy, 13, false);
             break;
         }
     }
 }
 
 // ============================================================================
-// FALLING STARS OVERLAY
+// PARTICLE OVERLAYS (falling stars for birthday, floating hearts for love)
 // ============================================================================
 
 #define MAX_STARS 8
 #define MAX_FLOATING_HEARTS 10
 
-typedef struct {
-    float x, y;
-    float speed;
-    float rotation;
-    float rot_speed;
-    int size;
-    bool active;
-} falling_star_t;
+// Star stamps: sizes 2-4, each spun through a quarter turn (the star
+// looks the same after one)
+#define STAR_MIN_SIZE  2
+#define STAR_SIZES     3
+#define STAR_ANGLES    16
+#define STAR_SPAN      (2 * (STAR_MIN_SIZE + STAR_SIZES - 1) + 1)
 
-typedef struct {
-    float x, y;
-    float speed;
-    float wobble;
-    int size;
-    bool active;
-} floating_heart_t;
-
-static falling_star_t stars[MAX_STARS];
-static floating_heart_t hearts[MAX_FLOATING_HEARTS];
-static bool stars_initialized = false;
-static bool hearts_initialized = false;
-static bool stars_enabled = false;
-static bool hearts_enabled = false;
-
-static void init_falling_stars(void) {
-    for (int i = 0; i < MAX_STARS; i++) {
-        stars[i].x = esp_random() % SCREEN_WIDTH;
-        stars[i].y = -(int)(esp_random() % 30);
-        stars[i].speed = 0.8f + (esp_random() % 100) / 80.0f;
-        stars[i].rotation = (esp_random() % 628) / 100.0f;
-        stars[i].rot_speed = 0.15f + (esp_random() % 20) / 80.0f;
-        stars[i].size = 2 + (esp_random() % 3);
-        stars[i].active = true;
-    }
-    stars_initialized = true;
-}
-
-static void update_falling_stars(void) {
-    if (!stars_initialized) init_falling_stars();
-    
-    for (int i = 0; i < MAX_STARS; i++) {
-        if (!stars[i].active) continue;
-        
-        stars[i].y += stars[i].speed;
-        stars[i].rotation += stars[i].rot_speed;
-        
-        if (stars[i].y > SCREEN_HEIGHT + 10) {
-            stars[i].x = esp_random() % SCREEN_WIDTH;
-            stars[i].y = -(int)(esp_random() % 15);
-            stars[i].speed = 0.8f + (esp_random() % 100) / 80.0f;
-            stars[i].size = 2 + (esp_random() % 3);
-            stars[i].rot_speed = 0.15f + (esp_random() % 20) / 80.0f;
-        }
-    }
+// Heart stamps: one per floating heart size, traced outlines fit in 9x9
+#define HEART_STAMP_SPAN  9
+
+static uint8_t star_stamp_data[STAR_SIZES * STAR_ANGLES][((STAR_SPAN + 7) / 8) * STAR_SPAN];
+static bitmap_t star_stamps[STAR_SIZES * STAR_ANGLES];
+static uint8_t heart_stamp_data[FLOATING_HEART_MAX - FLOATING_HEART_MIN + 1][((HEART_STAMP_SPAN + 7) / 8) * HEART_STAMP_SPAN];
+static bitmap_t heart_stamps[FLOATING_HEART_MAX - FLOATING_HEART_MIN + 1];
+
+static const particle_shape_t star_shape = {star_stamps, STAR_SIZES, STAR_ANGLES};
+static const particle_shape_t heart_shape = {heart_stamps, FLOATING_HEART_MAX - FLOATING_HEART_MIN + 1, 1};
+
+static particle_emitter_t *star_emitter = NULL;
+static particle_emitter_t *heart_emitter = NULL;
+
+static inline void stamp_pixel(bitmap_t *stamp, uint8_t *data, int x, int y) {
+    if (x < 0 || x >= stamp->width || y < 0 || y >= stamp->height) return;
+    data[(y / 8) * stamp->width + x] |= 1 << (y % 8);
 }
 
-static void draw_spinning_star(int cx, int cy, int size, float rotation) {
+// Four arms from the center at the given rotation, as the stars were drawn
+static void build_star_stamp(int size, float rotation, bitmap_t *stamp, uint8_t *data) {
+    int c = size;
+    *stamp = (bitmap_t){2 * size + 1, 2 * size + 1, data};
+    memset(data, 0, ((stamp->height + 7) / 8) * stamp->width);
+    
     for (int i = 0; i < 4; i++) {
         float angle = rotation + (i * M_PI / 2);
-        int x1 = cx + (int)(cosf(angle) * size);
-        int y1 = cy + (int)(sinf(angle) * size);
+        int x1 = c + (int)(cosf(angle) * size);
+        int y1 = c + (int)(sinf(angle) * size);
         
         int steps = size;
         for (int s = 0; s <= steps; s++) {
-            int px = cx + (x1 - cx) * s / steps;
-            int py = cy + (y1 - cy) * s / steps;
-            if (px >= 0 && px < SCREEN_WIDTH && py >= 0 && py < SCREEN_HEIGHT) {
-                ssd1306_set_pixel(px, py, false);
-            }
+            stamp_pixel(stamp, data, c + (x1 - c) * s / steps, c + (y1 - c) * s / steps);
         }
     }
-    if (cx >= 0 && cx < SCREEN_WIDTH && cy >= 0 && cy < SCREEN_HEIGHT) {
-        ssd1306_set_pixel(cx, cy, false);
-    }
+    stamp_pixel(stamp, data, c, c);
 }
 
-static void set_falling_stars_enabled(bool enabled) {
-    stars_enabled = enabled;
-    if (enabled && !stars_initialized) {
-        init_falling_stars();
+static void build_heart_stamp(const heart_outline_t *outline, bitmap_t *stamp, uint8_t *data) {
+    int c = HEART_STAMP_SPAN / 2;
+    *stamp = (bitmap_t){HEART_STAMP_SPAN, HEART_STAMP_SPAN, data};
+    memset(data, 0, ((HEART_STAMP_SPAN + 7) / 8) * HEART_STAMP_SPAN);
+    
+    for (int i = 0; i < outline->count; i++) {
+        const heart_span_t *s = &outline->spans[i];
+        for (int x = s->x; x < s->x + s->w; x++) stamp_pixel(stamp, data, c + x, c + s->dy);
     }
 }
 
-static void draw_falling_stars_overlay(void) {
-    if (!stars_enabled) return;
-
-    update_falling_stars();
-
-    for (int i = 0; i < MAX_STARS; i++) {
-        if (!stars[i].active) continue;
-        if (stars[i].y < 0 || stars[i].y >= SCREEN_HEIGHT) continue;
-
-        draw_spinning_star((int)stars[i].x, (int)stars[i].y,
-                          stars[i].size, stars[i].rotation);
+static void init_particle_overlays(void) {
+    for (int s = 0; s < STAR_SIZES; s++) {
+        for (int a = 0; a < STAR_ANGLES; a++) {
+            int i = s * STAR_ANGLES + a;
+            build_star_stamp(STAR_MIN_SIZE + s, a * (float)(M_PI / 2) / STAR_ANGLES,
+                             &star_stamps[i], star_stamp_data[i]);
+        }
     }
-}
-
-// ============================================================================
-// FLOATING HEARTS OVERLAY (for love emotion)
-// ============================================================================
-
-static void init_floating_hearts(void) {
-    for (int i = 0; i < MAX_FLOATING_HEARTS; i++) {
-        hearts[i].x = esp_random() % SCREEN_WIDTH;
-        hearts[i].y = SCREEN_HEIGHT + (int)(esp_random() % 20);
-        hearts[i].speed = 1.0f + (esp_random() % 100) / 100.0f;  // Faster: 1.0 to 2.0
-        hearts[i].wobble = (esp_random() % 628) / 100.0f;  // Random phase
-        hearts[i].size = 14 + (esp_random() % 7);  // Bigger: Size 14-20
-        hearts[i].active = true;
+    for (int size = FLOATING_HEART_MIN; size <= FLOATING_HEART_MAX; size++) {
+        int i = size - FLOATING_HEART_MIN;
+        build_heart_stamp(floating_heart(size), &heart_stamps[i], heart_stamp_data[i]);
     }
-    hearts_initialized = true;
-}
-
-static void update_floating_hearts(void) {
-    if (!hearts_initialized) init_floating_hearts();
-
-    for (int i = 0; i < MAX_FLOATING_HEARTS; i++) {
-        if (!hearts[i].active) continue;
-
-        hearts[i].y -= hearts[i].speed;
-        hearts[i].x += sinf(hearts[i].wobble) * 0.3f;
-        hearts[i].wobble += 0.1f;
-
-        // Reset heart when it goes off screen
-        if (hearts[i].y < -10) {
-            hearts[i].x = esp_random() % SCREEN_WIDTH;
-            hearts[i].y = SCREEN_HEIGHT + (int)(esp_random() % 20);
-            hearts[i].speed = 1.0f + (esp_random() % 100) / 100.0f;
-            hearts[i].wobble = (esp_random() % 628) / 100.0f;
-            hearts[i].size = 14 + (esp_random() % 7);
-        }
+    
+    // Stars fall from above the screen at 0.8-2 px/frame, spinning 0.15-0.4
+    // rad/frame (a quarter turn is 256 phase steps)
+    static const particle_emitter_config_t stars = {
+        .update = particle_kernel_drift,
+        .shape = &star_shape,
+        .rop = SSD1306_ROP_ANDNOT,
+        .count = MAX_STARS,
+        .spawn = {0, -14, SCREEN_WIDTH, 15},
+        .start = {0, -29, SCREEN_WIDTH, 30},
+        .vy_min = PARTICLE_FX(0.8), .vy_max = PARTICLE_FX(2.0),
+        .rate_min = 24, .rate_max = 65,
+        .size_min = 0, .size_max = STAR_SIZES - 1,
+        .margin = 10,
+    };
+    
+    // Hearts rise from below at 1-2 px/frame, weaving 0.3 px/frame side to
+    // side (0.1 rad/frame)
+    static const particle_emitter_config_t hearts = {
+        .update = particle_kernel_sway,
+        .shape = &heart_shape,
+        .rop = SSD1306_ROP_ANDNOT,
+        .count = MAX_FLOATING_HEARTS,
+        .spawn = {0, SCREEN_HEIGHT, SCREEN_WIDTH, 20},
+        .vy_min = -PARTICLE_FX(2.0), .vy_max = -PARTICLE_FX(1.0),
+        .rate_min = 4, .rate_max = 4,
+        .size_min = 0, .size_max = FLOATING_HEART_MAX - FLOATING_HEART_MIN,
+        .sway = PARTICLE_FX(0.3),
+        .margin = 10,
+    };
+    
+    star_emitter = particle_emitter_create(&stars);
+    heart_emitter = particle_emitter_create(&hearts);
+    if (!star_emitter || !heart_emitter) {
+        ESP_LOGW(TAG, "No room for overlay particles");
     }
 }
 
-static void draw_floating_heart(int cx, int cy, int size) {
-    // Draw a floating heart outline using parametric equation
-    float scale = size / 6.0f;  // Scale based on desired size (size 14-20)
-    for (float t = 0; t < 6.28f; t += 0.15f) {  // Fewer points for smaller hearts
-        float x = 16.0f * sinf(t) * sinf(t) * sinf(t);
-        float y = 13.0f * cosf(t) - 5.0f * cosf(2*t) - 2.0f * cosf(3*t) - cosf(4*t);
-        int px = cx + (int)(x * scale / 16.0f);
-        int py = cy - (int)(y * scale / 17.0f);
-
-        // Draw single pixel for tiny hearts
-        if (px >= 0 && px < SCREEN_WIDTH && py >= 0 && py < SCREEN_HEIGHT) {
-            ssd1306_set_pixel(px, py, false);
-        }
-    }
+static void set_falling_stars_enabled(bool enabled) {
+    if (enabled && !star_emitter) init_particle_overlays();
+    particle_emitter_enable(star_emitter, enabled);
 }
 
 static void set_floating_hearts_enabled(bool enabled) {
-    hearts_enabled = enabled;
-    if (enabled && !hearts_initialized) {
-        init_floating_hearts();
-    }
-}
-
-static void draw_floating_hearts_overlay(void) {
-    if (!hearts_enabled) return;
-
-    update_floating_hearts();
-
-    for (int i = 0; i < MAX_FLOATING_HEARTS; i++) {
-        if (!hearts[i].active) continue;
-        if (hearts[i].y < -5 || hearts[i].y >= SCREEN_HEIGHT + 5) continue;
-
-        draw_floating_heart((int)hearts[i].x, (int)hearts[i].y, hearts[i].size);
-    }
+    if (enabled && !heart_emitter) init_particle_overlays();
+    particle_emitter_enable(heart_emitter, enabled);
 }
 
 // ============================================================================
@@ -1301,14 +1675,10 @@ static void draw_birthday_cake(void) {
     int cake_bottom = cake_top + cake_height;
 
     // Draw cake outline
-    for (int x = cake_left; x <= cake_left + cake_width; x++) {
-        ssd1306_set_pixel(x, cake_top, false);        // Top
-        ssd1306_set_pixel(x, cake_bottom, false);     // Bottom
-    }
-    for (int y = cake_top; y <= cake_bottom; y++) {
-        ssd1306_set_pixel(cake_left, y, false);       // Left
-        ssd1306_set_pixel(cake_left + cake_width, y, false); // Right
-    }
+    ssd1306_hline(cake_left, cake_top, cake_width + 1, false);                // Top
+    ssd1306_hline(cake_left, cake_bottom, cake_width + 1, false);             // Bottom
+    ssd1306_vline(cake_left, cake_top, cake_height + 1, false);               // Left
+    ssd1306_vline(cake_left + cake_width, cake_top, cake_height + 1, false);  // Right
 
     // Cake top layer (smaller rectangle on top)
     int top_width = 35;
@@ -1316,98 +1686,317 @@ static void draw_birthday_cake(void) {
     int top_left = cake_center_x - top_width / 2;
     int top_top = cake_top - top_height;
 
-    for (int x = top_left; x <= top_left + top_width; x++) {
-        ssd1306_set_pixel(x, top_top, false);         // Top
-    }
-    for (int y = top_top; y <= cake_top; y++) {
-        ssd1306_set_pixel(top_left, y, false);        // Left
-        ssd1306_set_pixel(top_left + top_width, y, false); // Right
-    }
+    ssd1306_hline(top_left, top_top, top_width + 1, false);                   // Top
+    ssd1306_vline(top_left, top_top, top_height + 1, false);                  // Left
+    ssd1306_vline(top_left + top_width, top_top, top_height + 1, false);      // Right
 
     // Simple candle in the center
     int candle_x = cake_center_x;
     int candle_top = top_top - 8;
-    for (int y = candle_top; y <= top_top; y++) {
-        ssd1306_set_pixel(candle_x, y, false);        // Candle stick
-    }
+    ssd1306_vline(candle_x, candle_top, top_top - candle_top + 1, false);    // Candle stick
     // Candle flame (small triangle)
     ssd1306_set_pixel(candle_x, candle_top, false);
     ssd1306_set_pixel(candle_x - 1, candle_top + 1, false);
     ssd1306_set_pixel(candle_x + 1, candle_top + 1, false);
 }
 
+// Pixel rule for the simple 8x12 "HAPPY BIRTHDAY" letters
+static bool birthday_glyph_pixel(char c, int dx, int dy) {
+    switch (c) {
+        case 'H':
+            return (dx == 0 || dx == 7) || (dy == 6 && dx >= 1 && dx <= 6);
+        case 'A':
+            if ((dx == 0 || dx == 7) && dy > 2) return true;
+            return dy == 0 || dy == 6;
+        case 'P':
+            return dx == 0 || (dx == 7 && dy <= 6) || ((dy == 0 || dy == 6) && dx <= 6);
+        case 'Y':
+            if ((dx == dy/2 || dx == 7 - dy/2) && dy <= 6) return true;
+            return dy > 6 && dx == 3;
+        case 'B':
+            return dx == 0 || (dx == 6 && dy != 0 && dy != 6 && dy != 12) ||
+                   ((dy == 0 || dy == 6 || dy == 11) && dx <= 6);
+        case 'I':
+            return dx == 3 || dy == 0 || dy == 11;
+        case 'R':
+            if (dx == 0 || (dx == 6 && dy <= 6) || dy == 0 || dy == 6) return true;
+            return dy > 6 && dx == dy - 6;
+        case 'T':
+            return dy == 0 || dx == 3;
+        case 'D':
+            return dx == 0 || (dx == 6 && dy > 0 && dy < 11) ||
+                   ((dy == 0 || dy == 11) && dx <= 6);
+        default:
+            return false;
+    }
+}
+
+#define GLYPH_W  8
+#define GLYPH_H  12
+
+// Page-packed letter bitmaps (A-Z), built on first use
+static uint8_t glyph_data[26][GLYPH_W * ((GLYPH_H + 7) / 8)];
+static uint32_t glyph_built = 0;
+
+static bool birthday_glyph(char c, bitmap_t *out) {
+    if (c < 'A' || c > 'Z') return false;
+    int idx = c - 'A';
+    
+    if (!(glyph_built & (1u << idx))) {
+        memset(glyph_data[idx], 0, sizeof(glyph_data[idx]));
+        for (int dy = 0; dy < GLYPH_H; dy++) {
+            for (int dx = 0; dx < GLYPH_W; dx++) {
+                if (birthday_glyph_pixel(c, dx, dy)) {
+                    glyph_data[idx][(dy / 8) * GLYPH_W + dx] |= 1 << (dy % 8);
+                }
+            }
+        }
+        glyph_built |= 1u << idx;
+    }
+    
+    *out = (bitmap_t){GLYPH_W, GLYPH_H, glyph_data[idx]};
+    return true;
+}
+
+// "HAPPY BIRTHDAY" at the bottom in large text (~12px tall)
+#define BIRTHDAY_TEXT    "HAPPY BIRTHDAY"
+#define BIRTHDAY_TEXT_W  ((int)(sizeof(BIRTHDAY_TEXT) - 1) * GLYPH_W)
+#define BIRTHDAY_TEXT_X  ((SCREEN_WIDTH - BIRTHDAY_TEXT_W) / 2)
+#define BIRTHDAY_TEXT_Y  (SCREEN_HEIGHT - 15)   // Near bottom with some margin
+
 static void draw_birthday_text(void) {
-    // Draw "HAPPY BIRTHDAY" at the bottom in large text (~12px tall)
-    const char* text = "HAPPY BIRTHDAY";
+    const char* text = BIRTHDAY_TEXT;
     int text_len = strlen(text);
-    int char_width = 8;  // Approximate width per character
-    int total_width = text_len * char_width;
-    int start_x = (SCREEN_WIDTH - total_width) / 2;
-    int start_y = SCREEN_HEIGHT - 15;  // Near bottom with some margin
 
-    // Simple large text rendering (each character is 8x12 pixels)
+    // Each character is an 8x12 bitmap, drawn black on the white face
     for (int i = 0; i < text_len; i++) {
-        int char_x = start_x + i * char_width;
-        char c = text[i];
+        bitmap_t glyph;
+        if (birthday_glyph(text[i], &glyph)) {
+            ssd1306_blit(&glyph, BIRTHDAY_TEXT_X + i * GLYPH_W, BIRTHDAY_TEXT_Y, SSD1306_ROP_ANDNOT);
+        }
+    }
+}
 
-        // Draw each character as a simple 8x12 bitmap
-        // Using basic ASCII character patterns
-        for (int dy = 0; dy < 12; dy++) {
-            for (int dx = 0; dx < 8; dx++) {
-                int pixel_x = char_x + dx;
-                int pixel_y = start_y + dy;
-
-                if (pixel_x >= 0 && pixel_x < SCREEN_WIDTH &&
-                    pixel_y >= 0 && pixel_y < SCREEN_HEIGHT) {
-
-                    // Simple character patterns (very basic)
-                    bool draw_pixel = false;
-
-                    switch (c) {
-                        case 'H':
-                            if ((dx == 0 || dx == 7) || (dy == 6 && dx >= 1 && dx <= 6)) draw_pixel = true;
-                            break;
-                        case 'A':
-                            if ((dx == 0 || dx == 7) && dy > 2) draw_pixel = true;
-                            else if (dy == 0 || dy == 6) draw_pixel = true;
-                            break;
-                        case 'P':
-                            if (dx == 0 || (dx == 7 && dy <= 6) || ((dy == 0 || dy == 6) && dx <= 6)) draw_pixel = true;
-                            break;
-                        case 'Y':
-                            if ((dx == dy/2 || dx == 7 - dy/2) && dy <= 6) draw_pixel = true;
-                            else if (dy > 6 && dx == 3) draw_pixel = true;
-                            break;
-                        case 'B':
-                            if (dx == 0 || (dx == 6 && dy != 0 && dy != 6 && dy != 12) ||
-                                ((dy == 0 || dy == 6 || dy == 11) && dx <= 6)) draw_pixel = true;
-                            break;
-                        case 'I':
-                            if (dx == 3 || dy == 0 || dy == 11) draw_pixel = true;
-                            break;
-                        case 'R':
-                            if (dx == 0 || (dx == 6 && dy <= 6) || dy == 0 || dy == 6) draw_pixel = true;
-                            else if (dy > 6 && dx == dy - 6) draw_pixel = true;
-                            break;
-                        case 'T':
-                            if (dy == 0 || dx == 3) draw_pixel = true;
-                            break;
-                        case 'D':
-                            if (dx == 0 || (dx == 6 && dy > 0 && dy < 11) ||
-                                ((dy == 0 || dy == 11) && dx <= 6)) draw_pixel = true;
-                            break;
-                        case ' ':
-                            draw_pixel = false;
-                            break;
-                    }
+// ============================================================================
+// MARQUEE (hardware-scrolled banner)
+// ============================================================================
 
-                    if (draw_pixel) {
-                        ssd1306_set_pixel(pixel_x, pixel_y, false);
-                    }
-                }
-            }
+// Scrolling needs the panel itself, so other backends draw the text
+static bool marquee_wanted(void) {
+    return BIRTHDAY_MARQUEE && face.emotion == EMO_BIRTHDAY &&
+           display_get_backend() == &display_backend_ssd1306;
+}
+
+#if BIRTHDAY_MARQUEE
+#define MARQUEE_FIRST_PAGE       6
+#define MARQUEE_LAST_PAGE        7
+#define MARQUEE_Y                (MARQUEE_FIRST_PAGE * 8)
+#define MARQUEE_H                ((MARQUEE_LAST_PAGE - MARQUEE_FIRST_PAGE + 1) * 8)
+#define MARQUEE_FRAMES_PER_STEP  2
+
+static bool marquee_active = false;
+
+// Draw a message into the marquee band and let the panel scroll it.
+// Call once the rest of the frame is drawn.
+static void start_marquee(const char *text) {
+    int len = strlen(text);
+    int start_x = (SCREEN_WIDTH - len * GLYPH_W) / 2;
+    
+    // Text sits at the top of the band, so the blank rows below it are the
+    // ones that wrap to the top of the screen under HW_VERTICAL_SHIFT
+    ssd1306_fill_rect(0, MARQUEE_Y, SCREEN_WIDTH, MARQUEE_H, true);
+    for (int i = 0; i < len; i++) {
+        bitmap_t glyph;
+        if (birthday_glyph(text[i], &glyph)) {
+            ssd1306_blit(&glyph, start_x + i * GLYPH_W, MARQUEE_Y + 1, SSD1306_ROP_ANDNOT);
         }
     }
+    
+    marquee_active = (ssd1306_start_scroll(MARQUEE_FIRST_PAGE, MARQUEE_LAST_PAGE,
+                                           SSD1306_SCROLL_LEFT,
+                                           MARQUEE_FRAMES_PER_STEP) == ESP_OK);
+    
+    // The band no longer holds what the compositor drew there
+    compositor_invalidate();
+}
+
+static void stop_marquee(void) {
+    if (marquee_active && ssd1306_stop_scroll() == ESP_OK) {
+        marquee_active = false;
+        compositor_invalidate();
+    }
+}
+#endif
+
+// ============================================================================
+// FRAME LAYERS
+// ============================================================================
+
+// The face is drawn as compositor items, so a frame only repaints around
+// what changed. Everything an item's pixels depend on is in its
+// arguments, time and random jitter included; boxes must hold all of it.
+
+enum {
+    LAYER_BACKGROUND = 0,
+    LAYER_FACE,         // Mouth, brows, eyes and their effects
+    LAYER_OVERLAY,      // Particles and the cake
+    LAYER_TEXT,         // Birthday text, rows blanked for the panel shift
+};
+
+enum {
+    ITEM_BACKGROUND = 0,
+    ITEM_MOUTH,
+    ITEM_LEFT_BROW,
+    ITEM_RIGHT_BROW,
+    ITEM_LEFT_EYE,
+    ITEM_RIGHT_EYE,
+    ITEM_ZZZ,
+    ITEM_SWEAT,
+    ITEM_LEFT_BLUSH,
+    ITEM_RIGHT_BLUSH,
+    ITEM_CAKE,
+    ITEM_TEXT,
+    ITEM_SHIFT_BLANK,
+    ITEM_PARTICLE,      // Plus the particle's pool index
+};
+
+// Box around every mouth shape, relative to its center
+#define MOUTH_HALF_W  26
+#define MOUTH_TOP     10
+#define MOUTH_BOTTOM  18
+
+typedef struct {
+    int cx, cy, emotion;
+} mouth_args_t;
+
+typedef struct {
+    float angle;
+    int cx, cy, is_left;
+} brow_args_t;
+
+typedef struct {
+    int cx, cy;
+    eye_key_t key;
+} eye_args_t;
+
+typedef struct {
+    int cx, cy, beat;
+} heart_args_t;
+
+typedef struct {
+    int x, y, size;     // Sweat drop: drip length
+} mark_args_t;
+
+typedef struct {
+    const bitmap_t *bitmap;
+    int16_t x, y;
+    int32_t rop;
+} stamp_args_t;
+
+// White over the whole clip (background, blanked rows)
+static void draw_blank_item(const void *args) {
+    ssd1306_fill_rect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, true);
+}
+
+static void draw_mouth_item(const void *args) {
+    const mouth_args_t *a = args;
+    draw_mouth_2d(a->cx, a->cy, (emotion_t)a->emotion);
+}
+
+static void draw_brow_item(const void *args) {
+    const brow_args_t *a = args;
+    draw_eyebrow_2d(a->cx, a->cy, a->is_left, a->angle, 0);
+}
+
+static void draw_eye_item(const void *args) {
+    const eye_args_t *a = args;
+    draw_anime_eye_2d(a->cx, a->cy, &a->key);
+}
+
+static void draw_heart_item(const void *args) {
+    const heart_args_t *a = args;
+    heart_draw(love_heart(a->beat), a->cx, a->cy);
+}
+
+static void draw_zzz_item(const void *args) {
+    const mark_args_t *a = args;
+    draw_zzz_2d(a->x, a->y);
+}
+
+static void draw_sweat_item(const void *args) {
+    const mark_args_t *a = args;
+    ssd1306_vline(a->x, a->y, 6 + a->size, false);
+    ssd1306_vline(a->x - 1, a->y + 2, 3, false);
+    ssd1306_vline(a->x + 1, a->y + 2, 3, false);
+}
+
+static void draw_blush_item(const void *args) {
+    const mark_args_t *a = args;
+    for (int i = 0; i < 8; i += 2) {
+        ssd1306_set_pixel(a->x - 8 + i, a->y, false);
+    }
+}
+
+static void draw_stamp_item(const void *args) {
+    const stamp_args_t *a = args;
+    ssd1306_blit(a->bitmap, a->x, a->y, (ssd1306_rop_t)a->rop);
+}
+
+static void draw_cake_item(const void *args) {
+    draw_birthday_cake();
+}
+
+static void draw_text_item(const void *args) {
+    draw_birthday_text();
+}
+
+static void add_brow(uint16_t id, int cx, int cy, bool is_left, float angle) {
+    // Arch of 5 rows, tilted up to 5 px per unit of angle at the ends
+    int tilt = (int)(fabsf(angle) * 5.0f) + 1;
+    brow_args_t a = {angle, cx, cy, is_left};
+    compositor_add(LAYER_FACE, id, cx - 14, cy - 5 - tilt, 29, 10 + 2 * tilt,
+                   draw_brow_item, &a, sizeof(a));
+}
+
+static void add_eye(uint16_t id, int cx, int cy, int look_x, int look_y, float openness,
+                    bool is_left, emotion_t emo) {
+    if (face.shake > 0 && face.emotion != EMO_CRAZY) {
+        cx += (int)(face.shake * ((esp_random() % 5) - 2));
+    }
+    
+    int x0, y0, x1, y1;
+    if (emo == EMO_LOVE && openness > 0.3f) {
+        heart_args_t a = {cx, cy, love_heart_beat(xTaskGetTickCount() * portTICK_PERIOD_MS)};
+        heart_bounds(love_heart(a.beat), &x0, &y0, &x1, &y1);
+        compositor_add(LAYER_FACE, id, cx + x0, cy + y0, x1 - x0, y1 - y0,
+                       draw_heart_item, &a, sizeof(a));
+        return;
+    }
+    
+    eye_args_t a = {.cx = cx, .cy = cy};
+    eye_key_make(&a.key, look_x, look_y, openness, is_left, emo);
+    int x, y, w, h;
+    eye_box(cx, cy, &a.key, &x, &y, &w, &h);
+    compositor_add(LAYER_FACE, id, x, y, w, h, draw_eye_item, &a, sizeof(a));
+}
+
+static void add_blush(uint16_t id, int cx, int y) {
+    mark_args_t a = {cx, y, 0};
+    compositor_add(LAYER_FACE, id, cx - 8, y, 7, 1, draw_blush_item, &a, sizeof(a));
+}
+
+// One item per particle on screen, so each repaints on its own
+static void add_particle_items(const particle_emitter_t *em) {
+    if (!particle_emitter_enabled(em)) return;
+    
+    particle_stamp_t stamps[MAX_STARS > MAX_FLOATING_HEARTS ? MAX_STARS : MAX_FLOATING_HEARTS];
+    int count = particle_emitter_stamps(em, stamps, sizeof(stamps) / sizeof(stamps[0]));
+    for (int i = 0; i < count; i++) {
+        const particle_stamp_t *p = &stamps[i];
+        stamp_args_t a = {p->bitmap, p->x, p->y, particle_emitter_config(em)->rop};
+        compositor_add(LAYER_OVERLAY, ITEM_PARTICLE + p->index, p->x, p->y,
+                       p->bitmap->width, p->bitmap->height, draw_stamp_item, &a, sizeof(a));
+    }
 }
 
 // ============================================================================
@@ -1428,10 +2017,18 @@ static void update_3d_face(uint32_t now) {
     int rot_offset = (int)(head_rotation * 0.8f);
     int bounce_y = (int)(face.bounce * 3);
     
+    if (panel_shift_wanted()) {
+        face_shift_y = 0;
+        panel_shift_y = (int)(head_tilt * 0.3f) + bounce_y;
+    } else {
+        face_shift_y = (int)(head_tilt * 0.3f) + bounce_y;
+        panel_shift_y = 0;
+    }
+    
     left_eye.x = base_left_x + rot_offset;
     right_eye.x = base_right_x + rot_offset;
-    left_eye.y = base_y + (int)(head_tilt * 0.3f) + bounce_y;
-    right_eye.y = base_y + (int)(head_tilt * 0.3f) + bounce_y;
+    left_eye.y = base_y + face_shift_y;
+    right_eye.y = base_y + face_shift_y;
     
     left_eye.blink = 1.0f - face.left_eye_open;
     right_eye.blink = 1.0f - face.right_eye_open;
@@ -1442,16 +2039,18 @@ static void update_3d_face(uint32_t now) {
     right_eye.look_y = face.look_y;
 }
 
-static void draw_3d_face(void) {
-    ssd1306_fill();  // White background
+// Add the items of the face for the current state
+static void add_face_items(void) {
+    compositor_add(LAYER_BACKGROUND, ITEM_BACKGROUND, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT,
+                   draw_blank_item, NULL, 0);
     
     int bounce_y = (int)(face.bounce * 3);
+    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
     
     // Scared animation
     int scared_wiggle_x = 0;
     int scared_look_x = 0;
     if (face.emotion == EMO_SCARED) {
-        uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
         float anim_time = (float)(now - face.anim_start) / 1000.0f;
         scared_wiggle_x = (int)(sinf(anim_time * 12.0f) * 2);
         float dart = sinf(anim_time * 18.0f) + 0.3f * sinf(anim_time * 31.0f);
@@ -1464,14 +2063,21 @@ static void draw_3d_face(void) {
     // ========================================
     // MOUTH (2D drawing - reliable and clear)
     // ========================================
-    int mouth_x = (left_eye_x + right_eye_x) / 2;
-    int mouth_y = 48 + (int)(head_tilt * 0.3f) + bounce_y;
-    draw_mouth_2d(mouth_x, mouth_y, face.emotion);
+    mouth_args_t mouth = {
+        .cx = (left_eye_x + right_eye_x) / 2,
+        .cy = 48 + face_shift_y + (int)(face.bounce * 2),
+        .emotion = face.emotion,
+    };
+    compositor_add(LAYER_FACE, ITEM_MOUTH, mouth.cx - MOUTH_HALF_W, mouth.cy - MOUTH_TOP,
+                   2 * MOUTH_HALF_W + 1, MOUTH_TOP + MOUTH_BOTTOM + 1,
+                   draw_mouth_item, &mouth, sizeof(mouth));
     
     // Eyebrows
     int brow_y = left_eye.y - 18 + bounce_y;
-    draw_eyebrow_2d(left_eye_x, brow_y, true, face.left_brow_angle, face.left_brow_height);
-    draw_eyebrow_2d(right_eye_x, brow_y, false, face.right_brow_angle, face.right_brow_height);
+    add_brow(ITEM_LEFT_BROW, left_eye_x, brow_y + (int)face.left_brow_height, true,
+             face.left_brow_angle);
+    add_brow(ITEM_RIGHT_BROW, right_eye_x, brow_y + (int)face.right_brow_height, false,
+             face.right_brow_angle);
     
     // Eyes
     float left_openness = face.left_eye_open;
@@ -1481,8 +2087,6 @@ static void draw_3d_face(void) {
 
     if (face.emotion == EMO_CRAZY) {
         // Crazy rolling eyes - smooth animated motion between random positions
-        uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
-
         // Update target positions every 400-600ms for smooth rolling effect
         if (now >= face.next_crazy_look) {
             face.crazy_left_target_x = ((int)(esp_random() % 14)) - 7;
@@ -1503,79 +2107,227 @@ static void draw_3d_face(void) {
         int crazy_right_lx = look_x + (int)face.crazy_right_look_x;
         int crazy_right_ly = look_y + (int)face.crazy_right_look_y;
 
-        draw_anime_eye_2d(left_eye_x, left_eye.y, crazy_left_lx, crazy_left_ly,
-                          left_openness, true, face.emotion);
-        draw_anime_eye_2d(right_eye_x, right_eye.y, crazy_right_lx, crazy_right_ly,
-                          right_openness, false, face.emotion);
+        add_eye(ITEM_LEFT_EYE, left_eye_x, left_eye.y, crazy_left_lx, crazy_left_ly,
+                left_openness, true, face.emotion);
+        add_eye(ITEM_RIGHT_EYE, right_eye_x, right_eye.y, crazy_right_lx, crazy_right_ly,
+                right_openness, false, face.emotion);
     } else {
-        draw_anime_eye_2d(left_eye_x, left_eye.y, look_x, look_y,
-                          left_openness, true, face.emotion);
-        draw_anime_eye_2d(right_eye_x, right_eye.y, look_x, look_y,
-                          right_openness, false, face.emotion);
+        add_eye(ITEM_LEFT_EYE, left_eye_x, left_eye.y, look_x, look_y,
+                left_openness, true, face.emotion);
+        add_eye(ITEM_RIGHT_EYE, right_eye_x, right_eye.y, look_x, look_y,
+                right_openness, false, face.emotion);
     }
     
     // Special effects
     if (face.emotion == EMO_SLEEPING) {
-        draw_zzz_2d(100, 12);
+        mark_args_t zzz = {100, 12, 0};
+        compositor_add(LAYER_FACE, ITEM_ZZZ, zzz.x, zzz.y - 8, 22, 12, draw_zzz_item, &zzz, sizeof(zzz));
     }
     
     // Sweat drop for scared
     if (face.emotion == EMO_SCARED) {
-        int drop_x = right_eye_x + 22;
-        int drop_y = right_eye.y - 10;
-        uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
-        int drip_offset = (int)((now - face.anim_start) / 100) % 3;
-        for (int i = 0; i < 6 + drip_offset; i++) {
-            ssd1306_set_pixel(drop_x, drop_y + i, false);
-            if (i > 1 && i < 5) {
-                ssd1306_set_pixel(drop_x - 1, drop_y + i, false);
-                ssd1306_set_pixel(drop_x + 1, drop_y + i, false);
-            }
-        }
+        mark_args_t drop = {right_eye_x + 22, right_eye.y - 10, (int)((now - face.anim_start) / 100) % 3};
+        compositor_add(LAYER_FACE, ITEM_SWEAT, drop.x - 1, drop.y, 3, 6 + drop.size,
+                       draw_sweat_item, &drop, sizeof(drop));
     }
     
     // Blush
-    if (face.emotion == EMO_LOVE || face.emotion == EMO_HAPPY) {
+    if (face.emotion == EMO_LOVE || face.emotion == EMO_HAPPY || face.emotion == EMO_BIRTHDAY) {
         int blush_y = left_eye.y + 12;
-        for (int i = 0; i < 8; i++) {
-            if (i % 2 == 0) {
-                ssd1306_set_pixel(left_eye_x - 8 + i, blush_y, false);
-                ssd1306_set_pixel(right_eye_x - 8 + i, blush_y, false);
-            }
-        }
+        add_blush(ITEM_LEFT_BLUSH, left_eye_x, blush_y);
+        add_blush(ITEM_RIGHT_BLUSH, right_eye_x, blush_y);
     }
     
-    // Falling stars for birthday
+    // Falling stars for birthday, floating hearts for love
+    set_falling_stars_enabled(face.emotion == EMO_BIRTHDAY);
+    set_floating_hearts_enabled(face.emotion == EMO_LOVE);
+    particles_update();
+    add_particle_items(star_emitter);
+    add_particle_items(heart_emitter);
+
+    // Birthday cake and text
     if (face.emotion == EMO_BIRTHDAY) {
-        set_falling_stars_enabled(true);
-        int blush_y = left_eye.y + 12;
-        for (int i = 0; i < 8; i++) {
-            if (i % 2 == 0) {
-                ssd1306_set_pixel(left_eye_x - 8 + i, blush_y, false);
-                ssd1306_set_pixel(right_eye_x - 8 + i, blush_y, false);
-            }
+        // From the candle tip down to the base
+        compositor_add(LAYER_OVERLAY, ITEM_CAKE, SCREEN_WIDTH / 2 - 20, -4, 41, 37,
+                       draw_cake_item, NULL, 0);
+        if (!marquee_wanted()) {
+            compositor_add(LAYER_TEXT, ITEM_TEXT, BIRTHDAY_TEXT_X, BIRTHDAY_TEXT_Y,
+                           BIRTHDAY_TEXT_W, GLYPH_H, draw_text_item, NULL, 0);
         }
-    } else {
-        set_falling_stars_enabled(false);
-    }
-
-    // Floating hearts for love
-    if (face.emotion == EMO_LOVE) {
-        set_floating_hearts_enabled(true);
-    } else {
-        set_floating_hearts_enabled(false);
     }
     
-    draw_falling_stars_overlay();
-    draw_floating_hearts_overlay();
+    // Rows that wrap around to the other edge under the panel shift are
+    // blanked, as a redraw at the shifted position would have
+    if (panel_shift_y != 0) {
+        int x, y, w, h;
+        ssd1306_get_offset_wrap(panel_shift_y, &x, &y, &w, &h);
+        compositor_add(LAYER_TEXT, ITEM_SHIFT_BLANK, x, y, w, h, draw_blank_item, NULL, 0);
+    }
+}
 
-    // Birthday cake and text
-    if (face.emotion == EMO_BIRTHDAY) {
-        draw_birthday_cake();
-        draw_birthday_text();
+// Draw the face for the current state into the frame buffer, repainting
+// only what changed since the last frame
+static void draw_face_2d(void) {
+#if !PARTIAL_REDRAW
+    compositor_invalidate();
+#endif
+    compositor_begin();
+    add_face_items();
+    compositor_end();
+}
+
+#if RUN_BENCHMARKS
+static void draw_face_2d_whole(void) {
+    compositor_invalidate();
+    draw_face_2d();
+}
+#endif
+
+static void draw_3d_face(void) {
+#if BIRTHDAY_MARQUEE
+    if (!marquee_wanted()) stop_marquee();
+    // The panel owns the band while it scrolls; don't draw there. The
+    // rest still goes to the frame buffer and shows once it stops.
+    if (marquee_active) ssd1306_push_clip(0, 0, SCREEN_WIDTH, MARQUEE_Y);
+#endif
+    
+    draw_face_2d();
+    
+    if (panel_shift_wanted()) ssd1306_set_vertical_offset(panel_shift_y);
+#if BIRTHDAY_MARQUEE
+    if (marquee_active) {
+        ssd1306_pop_clip();
+    } else if (marquee_wanted()) {
+        start_marquee(BIRTHDAY_TEXT);
     }
+#endif
+    display_present();
+}
 
-    ssd1306_update();
+#if SSD1306_HOST_BUS
+// Report average bus traffic per frame for each emotion when it ends.
+// Call once per frame, before the face is updated.
+static void log_bus_usage(void) {
+    static emotion_t emotion = EMO_COUNT;
+    static uint32_t frames = 0;
+    
+    if (face.emotion != emotion) {
+        ssd1306_wait_idle();  // Counters are updated by the flush task
+        if (emotion != EMO_COUNT && frames > 0) {
+            hostbus_stats_t stats;
+            hostbus_get_stats(&stats);
+            ESP_LOGI(TAG, "Emotion %d: %lu bus bytes/frame (%lu data) in %lu.%02lu transactions/frame over %lu frames",
+                     emotion, (unsigned long)(stats.bytes / frames),
+                     (unsigned long)(stats.data_bytes / frames),
+                     (unsigned long)(stats.transactions / frames),
+                     (unsigned long)(stats.transactions * 100 / frames % 100),
+                     (unsigned long)frames);
+        }
+        hostbus_reset_stats();
+        emotion = face.emotion;
+        frames = 0;
+    }
+    frames++;
+}
+#endif
+
+// Log the display pipeline's counters. Call every 100 frames.
+static void log_frame_stats(uint32_t frame_count) {
+    static ssd1306_stats_t last;
+    uint32_t pages_sent, pages_skipped;
+    ssd1306_async_stats_t async;
+    ssd1306_stats_t flush;
+    ssd1306_get_page_stats(&pages_sent, &pages_skipped);
+    ssd1306_get_async_stats(&async);
+    ssd1306_get_stats(&flush);
+    
+    // Averages over the flushes since the last report, against the 8 ms
+    // frame budget
+    uint32_t flushes = flush.flushes - last.flushes;
+    uint32_t div = flushes ? flushes : 1;
+    ESP_LOGI(TAG, "Frame %lu: %lu flushes (%lu skipped), avg %lu us, %lu bytes and %lu transactions per flush; "
+             "max %lu us, %lu bus errors since boot (pages sent %lu, skipped %lu; flush waits %lu/%lu, max %lu us; "
+             "%lu unchanged frames not sent)",
+             (unsigned long)frame_count, (unsigned long)flushes,
+             (unsigned long)(flush.skipped_flushes - last.skipped_flushes),
+             (unsigned long)((flush.flush_us_total - last.flush_us_total) / div),
+             (unsigned long)((flush.bytes - last.bytes) / div),
+             (unsigned long)((flush.transactions - last.transactions) / div),
+             (unsigned long)flush.flush_us_max, (unsigned long)flush.bus_errors,
+             (unsigned long)pages_sent, (unsigned long)pages_skipped,
+             (unsigned long)async.waits, (unsigned long)async.presents,
+             (unsigned long)async.wait_us_max, (unsigned long)async.skipped);
+    last = flush;
+    
+#if SSD1306_STATS_HISTORY
+    // Slowest of the recent flushes, and what it sent
+    static ssd1306_frame_sample_t samples[SSD1306_STATS_HISTORY];
+    int count = ssd1306_get_frame_samples(samples, SSD1306_STATS_HISTORY);
+    int slowest = 0;
+    for (int i = 1; i < count; i++) {
+        if (samples[i].flush_us > samples[slowest].flush_us) slowest = i;
+    }
+    if (count > 0) {
+        ESP_LOGI(TAG, "Slowest of the last %d flushes: %lu us, %u bytes in %u transactions, %u pages, %u errors",
+                 count, (unsigned long)samples[slowest].flush_us, samples[slowest].bytes,
+                 samples[slowest].transactions, samples[slowest].pages, samples[slowest].bus_errors);
+    }
+#endif
+#if EYE_CACHE_BYTES
+    static eye_cache_stats_t last_eyes;
+    ESP_LOGI(TAG, "Eye cache: %lu hits, %lu misses, %lu uncached (%lu evictions since boot, %d slots)",
+             (unsigned long)(eye_cache_stats.hits - last_eyes.hits),
+             (unsigned long)(eye_cache_stats.misses - last_eyes.misses),
+             (unsigned long)(eye_cache_stats.uncached - last_eyes.uncached),
+             (unsigned long)eye_cache_stats.evictions, (int)EYE_CACHE_SLOTS);
+    last_eyes = eye_cache_stats;
+#endif
+    
+    // What the frames since the last report repainted
+    static compositor_stats_t last_comp;
+    compositor_stats_t comp;
+    compositor_get_stats(&comp);
+    uint32_t frames = comp.frames - last_comp.frames;
+    uint32_t frames_div = frames ? frames : 1;
+    ESP_LOGI(TAG, "Compositor: %lu frames (%lu whole, %lu unchanged), %lu regions and %lu item draws, avg %lu px per frame; "
+             "items changed %lu face, %lu overlay, %lu text",
+             (unsigned long)frames, (unsigned long)(comp.full - last_comp.full),
+             (unsigned long)(comp.unchanged - last_comp.unchanged),
+             (unsigned long)(comp.rects - last_comp.rects),
+             (unsigned long)(comp.draws - last_comp.draws),
+             (unsigned long)((comp.pixels - last_comp.pixels) / frames_div),
+             (unsigned long)(comp.changed[LAYER_FACE] - last_comp.changed[LAYER_FACE]),
+             (unsigned long)(comp.changed[LAYER_OVERLAY] - last_comp.changed[LAYER_OVERLAY]),
+             (unsigned long)(comp.changed[LAYER_TEXT] - last_comp.changed[LAYER_TEXT]));
+    if (comp.dropped) {
+        ESP_LOGW(TAG, "Compositor dropped %lu items since boot", (unsigned long)comp.dropped);
+    }
+    last_comp = comp;
+    if (ssd1306_get_gray_mode()) {
+        ssd1306_gray_stats_t gray;
+        ssd1306_get_gray_stats(&gray);
+        ESP_LOGI(TAG, "Gray slots %lu (planes sent %lu, dropped %lu, %lu planes/s)",
+                 (unsigned long)gray.slots, (unsigned long)gray.planes_sent,
+                 (unsigned long)gray.dropped, (unsigned long)gray.plane_rate_hz);
+    }
+    ssd1306_bus_stats_t bus;
+    ssd1306_get_bus_stats(&bus);
+    if (bus.timeouts || bus.nacks) {
+        ESP_LOGW(TAG, "I2C errors: %lu timeouts, %lu NACKs (%lu bus resets, %lu controller resets)",
+                 (unsigned long)bus.timeouts, (unsigned long)bus.nacks,
+                 (unsigned long)bus.bus_resets, (unsigned long)bus.controller_resets);
+    }
+    // Big redraws run past the deadline as a matter of course
+    if (bus.deadline_aborts) {
+        ESP_LOGI(TAG, "Flushes cut short by the deadline: %lu", (unsigned long)bus.deadline_aborts);
+    }
+    if (framestream_active()) {
+        framestream_stats_t stream;
+        framestream_get_stats(&stream);
+        ESP_LOGI(TAG, "Frame stream: %lu frames (%lu key), %lu bytes/frame",
+                 (unsigned long)stream.frames, (unsigned long)stream.key_frames,
+                 (unsigned long)(stream.frames ? stream.bytes / stream.frames : 0));
+    }
 }
 
 // ============================================================================
@@ -1586,12 +2338,45 @@ void app_main(void)
 {
     ESP_LOGI(TAG, "=== Desktoy (Hybrid 2D/3D Rendering) ===");
     
-    esp_err_t ret = ssd1306_init(I2C_SDA_PIN, I2C_SCL_PIN, OLED_I2C_ADDR);
+    esp_err_t ret = display_init(&DISPLAY_BACKEND, &display_config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Display init failed!");
         return;
     }
     
+    if (display_get_backend() == &display_backend_ssd1306 &&
+        (DISPLAY_ORIENTATION != SSD1306_ROT_0 || DISPLAY_MIRROR)) {
+        ssd1306_set_orientation(DISPLAY_ORIENTATION, DISPLAY_MIRROR);
+    }
+    
+#if FRAME_STREAM
+    if (display_get_backend() == &display_backend_ssd1306) {
+#if SSD1306_HOST_BUS
+        ret = framestream_start_file(FRAME_STREAM_PATH);
+#else
+        ret = framestream_start_uart(FRAME_STREAM_UART, FRAME_STREAM_TX_PIN, FRAME_STREAM_BAUD);
+#endif
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Frame stream unavailable");
+        }
+    }
+#endif
+    
+#if I2C_AUTOTUNE
+    ssd1306_bench_result_t bus;
+    if (display_get_backend() == &display_backend_ssd1306 &&
+        ssd1306_benchmark(&bus, true) == ESP_OK) {
+        ESP_LOGI(TAG, "I2C at %lu kHz", (unsigned long)(bus.selected_hz / 1000));
+    }
+#endif
+    
+#if GRAYSCALE_EYES
+    if (display_get_backend() == &display_backend_ssd1306 &&
+        ssd1306_set_gray_mode(true) != ESP_OK) {
+        ESP_LOGW(TAG, "Grayscale mode unavailable - using dithered eyes");
+    }
+#endif
+    
     // Splash screen
     ESP_LOGI(TAG, "Showing splash screen...");
     draw_splash_screen("KRG");
@@ -1606,6 +2391,10 @@ void app_main(void)
         buzzer_set_volume(60);
     }
     
+#if RUN_BENCHMARKS
+    bench_run_all();
+#endif
+    
     // Initialize 3D scene
     init_3d_scene();
     ESP_LOGI(TAG, "3D renderer initialized");
@@ -1630,6 +2419,22 @@ void app_main(void)
     apply_emotion(EMO_TROLLFACE);
     ESP_LOGI(TAG, "Starting with trollface emotion");
     
+#if RUN_BENCHMARKS
+    if (display_get_backend() == &display_backend_ssd1306) {
+        bench_compare("love eye heart", love_heart_before, love_heart_after);
+        bench_compare("floating heart 17", floating_heart_before, floating_heart_after);
+        
+        bench_frame("face frame", draw_face_2d_whole);
+        bench_frame("face frame, unchanged", draw_face_2d);
+        
+        // Heart eyes and floating hearts; only the hearts move
+        apply_emotion_silent(EMO_LOVE);
+        bench_frame("love frame", draw_face_2d_whole);
+        bench_frame("love frame, partial", draw_face_2d);
+        apply_emotion_silent(EMO_TROLLFACE);
+    }
+#endif
+    
     ESP_LOGI(TAG, "Starting animation...");
     
     uint32_t frame_count = 0;
@@ -1640,6 +2445,9 @@ void app_main(void)
         uint32_t delta_ms = now - last_time;
         last_time = now;
         
+#if SSD1306_HOST_BUS
+        log_bus_usage();
+#endif
         update_3d_face(now);
         draw_3d_face();
         
@@ -1647,7 +2455,7 @@ void app_main(void)
         
         frame_count++;
         if (frame_count % 100 == 0) {
-            ESP_LOGI(TAG, "Frame %lu", (unsigned long)frame_count);
+            log_frame_stats(frame_count);
         }
         
         vTaskDelay(pdMS_TO_TICKS(8));
@@ -0,0 +1,111 @@
+/*
+ * Display Backend Layer Implementation
+ * Dispatch plus the SSD1306 and null backends
+ */
+
+#include "display.h"
+#include "ssd1306.h"
+#include "esp_log.h"
+
+static const char *TAG = "display";
+
+static const display_backend_t *active = NULL;
+
+// ============================================================================
+// DISPATCH
+// ============================================================================
+
+esp_err_t display_init(const display_backend_t *backend, const display_config_t *config) {
+    if (!backend || !config) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t ret = backend->init(config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "%s backend init failed: %s", backend->name, esp_err_to_name(ret));
+        return ret;
+    }
+
+    active = backend;
+    ESP_LOGI(TAG, "Using %s backend (%dx%d)", backend->name, backend->width, backend->height);
+    return ESP_OK;
+}
+
+esp_err_t display_flush(const display_frame_t *frame) {
+    if (!active) return ESP_ERR_INVALID_STATE;
+    if (!frame || !frame->pixels) return ESP_ERR_INVALID_ARG;
+    return active->flush(frame);
+}
+
+esp_err_t display_present(void) {
+    display_frame_t frame = {
+        .format = DISPLAY_FORMAT_MONO_PAGED,
+        .width = SSD1306_WIDTH,
+        .height = SSD1306_HEIGHT,
+        .pixels = ssd1306_get_buffer(),
+    };
+    return display_flush(&frame);
+}
+
+void display_set_contrast(uint8_t contrast) {
+    if (active && active->set_contrast) {
+        active->set_contrast(contrast);
+    }
+}
+
+const display_backend_t* display_get_backend(void) {
+    return active;
+}
+
+// ============================================================================
+// SSD1306 BACKEND
+// ============================================================================
+
+static esp_err_t ssd1306_backend_init(const display_config_t *config) {
+    return ssd1306_init(config->sda_pin, config->scl_pin, config->i2c_addr);
+}
+
+static esp_err_t ssd1306_backend_flush(const display_frame_t *frame) {
+    if (frame->format != DISPLAY_FORMAT_MONO_PAGED ||
+        frame->width != SSD1306_WIDTH || frame->height != SSD1306_HEIGHT) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // Frames drawn elsewhere are copied into the drawing buffer first
+    if (frame->pixels != ssd1306_get_buffer()) {
+        bitmap_t bmp = {SSD1306_WIDTH, SSD1306_HEIGHT, frame->pixels};
+        ssd1306_blit(&bmp, 0, 0, SSD1306_ROP_COPY);
+    }
+    ssd1306_present_async();
+    return ESP_OK;
+}
+
+const display_backend_t display_backend_ssd1306 = {
+    .name = "ssd1306",
+    .width = SSD1306_WIDTH,
+    .height = SSD1306_HEIGHT,
+    .init = ssd1306_backend_init,
+    .flush = ssd1306_backend_flush,
+    .set_contrast = ssd1306_set_contrast,
+};
+
+// ============================================================================
+// NULL BACKEND
+// ============================================================================
+
+static esp_err_t null_backend_init(const display_config_t *config) {
+    (void)config;
+    return ESP_OK;
+}
+
+static esp_err_t null_backend_flush(const display_frame_t *frame) {
+    (void)frame;
+    return ESP_OK;
+}
+
+const display_backend_t display_backend_null = {
+    .name = "null",
+    .width = SSD1306_WIDTH,
+    .height = SSD1306_HEIGHT,
+    .init = null_backend_init,
+    .flush = null_backend_flush,
+    .set_contrast = NULL,
+};
@@ -0,0 +1,108 @@
+/*
+ * Display Backend Layer
+ * Lets the same rendering code present frames to the SSD1306 over I2C,
+ * to nothing (for profiling the renderer alone), or to files / a pipe
+ * on a host build
+ */
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Pixel layouts a frame can be handed over in
+typedef enum {
+    DISPLAY_FORMAT_MONO_PAGED = 0,  // 1bpp, pages of 8 rows, bit 0 = top (SSD1306 layout)
+    DISPLAY_FORMAT_RGB565,          // 16bpp, row-major
+} display_format_t;
+
+// Description of one frame
+typedef struct {
+    display_format_t format;
+    uint16_t width;
+    uint16_t height;
+    const void *pixels;
+} display_frame_t;
+
+// Host backend output
+typedef enum {
+    DISPLAY_HOST_PBM = 0,   // One PBM (mono) or PPM (color) file per frame
+    DISPLAY_HOST_RAW,       // Raw frames appended to one file or pipe
+} display_host_mode_t;
+
+// Settings for all backends; each reads only its own fields
+typedef struct {
+    // SSD1306 over I2C
+    int sda_pin;
+    int scl_pin;
+    uint8_t i2c_addr;
+
+    // Host
+    display_host_mode_t host_mode;
+    const char *host_path;  // PBM: file name pattern with one %u for the
+                            // frame number. RAW: file or FIFO, "-" = stdout
+} display_config_t;
+
+// Backend interface
+typedef struct {
+    const char *name;
+    uint16_t width;     // Native resolution
+    uint16_t height;
+    esp_err_t (*init)(const display_config_t *config);
+    esp_err_t (*flush)(const display_frame_t *frame);
+    void (*set_contrast)(uint8_t contrast);     // May be NULL
+} display_backend_t;
+
+/**
+ * SSD1306 panel through the driver in ssd1306.h
+ * Takes 128x64 mono frames; presents them with ssd1306_present_async().
+ */
+extern const display_backend_t display_backend_ssd1306;
+
+/**
+ * Accepts and discards every frame
+ */
+extern const display_backend_t display_backend_null;
+
+/**
+ * Writes frames to disk or a pipe (see display_host_mode_t)
+ * Raw mono frames are 8-bit gray (0 or 255), row-major, and raw color
+ * frames are RGB565 little-endian, so they can be piped to e.g.
+ *   ffplay -f rawvideo -pixel_format gray -video_size 128x64 -i <path>
+ */
+extern const display_backend_t display_backend_host;
+
+/**
+ * Select and initialize the display backend
+ * @param backend One of the display_backend_* instances
+ * @param config Backend settings
+ * @return ESP_OK on success
+ */
+esp_err_t display_init(const display_backend_t *backend, const display_config_t *config);
+
+/**
+ * Hand a frame to the backend
+ * @return ESP_ERR_INVALID_STATE before display_init(), ESP_ERR_NOT_SUPPORTED
+ *         if the backend can't show this format
+ */
+esp_err_t display_flush(const display_frame_t *frame);
+
+/**
+ * Flush the SSD1306 drawing buffer (what the ssd1306_* primitives draw to)
+ */
+esp_err_t display_present(void);
+
+/**
+ * Set display brightness, if the backend supports it
+ * @param contrast 0-255
+ */
+void display_set_contrast(uint8_t contrast);
+
+/**
+ * Get the active backend (NULL before display_init())
+ */
+const display_backend_t* display_get_backend(void);
+
+#endif // DISPLAY_H
@@ -0,0 +1,129 @@
+/*
+ * Host Display Backend
+ * Writes frames as PBM/PPM files or streams them raw to a file or pipe,
+ * so rendering can run and be inspected without a panel or bus
+ */
+
+#include "display.h"
+#include "ssd1306.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "display_host";
+
+#define MAX_PATH  256
+
+static display_host_mode_t mode = DISPLAY_HOST_PBM;
+static const char *path_pattern = NULL;
+static FILE *stream = NULL;
+static uint32_t frame_number = 0;
+
+static inline bool mono_pixel(const display_frame_t *frame, int x, int y) {
+    const uint8_t *pages = frame->pixels;
+    return (pages[(y >> 3) * frame->width + x] >> (y & 7)) & 1;
+}
+
+// PBM rows: MSB-first, 1 = black, so lit pixels are written as 0 bits
+static void write_pbm(FILE *f, const display_frame_t *frame) {
+    fprintf(f, "P4\n%d %d\n", frame->width, frame->height);
+    for (int y = 0; y < frame->height; y++) {
+        uint8_t byte = 0;
+        for (int x = 0; x < frame->width; x++) {
+            if (!mono_pixel(frame, x, y)) byte |= 0x80 >> (x & 7);
+            if ((x & 7) == 7 || x == frame->width - 1) {
+                fputc(byte, f);
+                byte = 0;
+            }
+        }
+    }
+}
+
+static void write_ppm(FILE *f, const display_frame_t *frame) {
+    const uint16_t *src = frame->pixels;
+    fprintf(f, "P6\n%d %d\n255\n", frame->width, frame->height);
+    for (int i = 0; i < frame->width * frame->height; i++) {
+        uint16_t c = src[i];
+        uint8_t rgb[3] = {
+            (uint8_t)(((c >> 11) & 0x1F) * 255 / 31),
+            (uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+            (uint8_t)((c & 0x1F) * 255 / 31),
+        };
+        fwrite(rgb, 1, sizeof(rgb), f);
+    }
+}
+
+static void write_raw(FILE *f, const display_frame_t *frame) {
+    if (frame->format == DISPLAY_FORMAT_RGB565) {
+        const uint16_t *src = frame->pixels;
+        for (int i = 0; i < frame->width * frame->height; i++) {
+            uint8_t le[2] = {(uint8_t)(src[i] & 0xFF), (uint8_t)(src[i] >> 8)};
+            fwrite(le, 1, sizeof(le), f);
+        }
+        return;
+    }
+
+    // Mono: one gray byte per pixel, one row at a time
+    uint8_t row[256];
+    for (int y = 0; y < frame->height; y++) {
+        for (int x = 0; x < frame->width; x++) {
+            row[x] = mono_pixel(frame, x, y) ? 0xFF : 0x00;
+        }
+        fwrite(row, 1, frame->width, f);
+    }
+}
+
+static esp_err_t host_backend_init(const display_config_t *config) {
+    if (!config->host_path) return ESP_ERR_INVALID_ARG;
+
+    mode = config->host_mode;
+    path_pattern = config->host_path;
+    frame_number = 0;
+
+    if (mode == DISPLAY_HOST_RAW) {
+        if (stream && stream != stdout) fclose(stream);
+        stream = (strcmp(path_pattern, "-") == 0) ? stdout : fopen(path_pattern, "wb");
+        if (!stream) {
+            ESP_LOGE(TAG, "Can't open %s", path_pattern);
+            return ESP_FAIL;
+        }
+    }
+
+    ESP_LOGI(TAG, "Writing %s frames to %s", (mode == DISPLAY_HOST_RAW) ? "raw" : "PBM",
+             path_pattern);
+    return ESP_OK;
+}
+
+static esp_err_t host_backend_flush(const display_frame_t *frame) {
+    if (mode == DISPLAY_HOST_RAW) {
+        if (!stream) return ESP_ERR_INVALID_STATE;
+        if (frame->width > 256) return ESP_ERR_NOT_SUPPORTED;   // Row buffer size
+        write_raw(stream, frame);
+        fflush(stream);     // Keep a reader on the other end of a pipe in step
+        frame_number++;
+        return ferror(stream) ? ESP_FAIL : ESP_OK;
+    }
+
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), path_pattern, (unsigned)frame_number++);
+    FILE *f = fopen(path, "wb");
+    if (!f) return ESP_FAIL;
+
+    if (frame->format == DISPLAY_FORMAT_RGB565) {
+        write_ppm(f, frame);
+    } else {
+        write_pbm(f, frame);
+    }
+    bool failed = ferror(f);
+    fclose(f);
+    return failed ? ESP_FAIL : ESP_OK;
+}
+
+const display_backend_t display_backend_host = {
+    .name = "host",
+    .width = SSD1306_WIDTH,
+    .height = SSD1306_HEIGHT,
+    .init = host_backend_init,
+    .flush = host_backend_flush,
+    .set_contrast = NULL,
+};
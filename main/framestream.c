@@ -0,0 +1,333 @@
+/*
+ * Frame Stream Implementation
+ * Packets are built a page at a time straight into a small output buffer:
+ * the delta is taken against the driver's copy of what the panel held, so
+ * no second frame buffer is needed here
+ */
+
+#include "framestream.h"
+#include "framestream_format.h"
+#include "ssd1306.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+#if !SSD1306_HOST_BUS
+#include "driver/uart.h"
+#endif
+
+static const char *TAG = "framestream";
+
+// Bytes collected before a call to the sink
+#define OUT_BUFFER  64
+
+static struct {
+    SemaphoreHandle_t lock;         // Taken by every call that touches the stream
+    framestream_write_fn write;     // NULL = stopped
+    void *ctx;
+    FILE *file;                     // Opened by framestream_start_file()
+    uint32_t epoch;
+    uint8_t seq;
+
+    // Delta packet being built: its page, the columns it covers so far,
+    // and the zero run not yet written out
+    bool open;
+    uint8_t addr;
+    uint8_t page;
+    int col;
+    int zeros;
+    framestream_check_t check;
+
+    uint8_t out[OUT_BUFFER];
+    size_t out_len;
+
+    framestream_stats_t stats;
+} fs;
+
+// ============================================================================
+// OUTPUT
+// ============================================================================
+
+static void out_flush(void) {
+    if (fs.out_len) fs.write(fs.out, fs.out_len, fs.ctx);
+    fs.stats.bytes += fs.out_len;
+    fs.out_len = 0;
+}
+
+static inline void out_byte(uint8_t byte) {
+    fs.out[fs.out_len++] = byte;
+    if (fs.out_len == OUT_BUFFER) out_flush();
+}
+
+// A byte inside the checked part of a packet
+static inline void put(uint8_t byte) {
+    framestream_check_add(&fs.check, byte);
+    out_byte(byte);
+}
+
+static void packet_begin(uint8_t type, uint8_t addr, uint8_t arg) {
+    out_byte(FRAMESTREAM_SYNC0);
+    out_byte(FRAMESTREAM_SYNC1);
+    fs.check = (framestream_check_t){0, 0};
+    put(type);
+    put(fs.seq++);
+    put(addr);
+    put(arg);
+}
+
+static void packet_end(void) {
+    uint8_t a = fs.check.a, b = fs.check.b;
+    out_byte(a);
+    out_byte(b);
+    out_flush();
+    fs.stats.packets++;
+}
+
+// ============================================================================
+// RUN-LENGTH CODING
+// ============================================================================
+
+static void put_zeros(void) {
+    while (fs.zeros > 0) {
+        int n = (fs.zeros > FRAMESTREAM_MAX_ZEROS) ? FRAMESTREAM_MAX_ZEROS : fs.zeros;
+        put(FRAMESTREAM_ZEROS | (n - 1));
+        fs.zeros -= n;
+    }
+}
+
+// Code len bytes: cur XOR old, or cur alone for a key page (old = NULL).
+// Zero runs are held back so they merge across spans.
+static void put_bytes(const uint8_t *old, const uint8_t *cur, int len) {
+#define VALUE(i)  (old ? (uint8_t)(old[i] ^ cur[i]) : cur[i])
+    int i = 0;
+    while (i < len) {
+        uint8_t v = VALUE(i);
+        if (v == 0) {
+            fs.zeros++;
+            i++;
+            continue;
+        }
+        put_zeros();
+
+        int run = 1;
+        while (i + run < len && run < FRAMESTREAM_MAX_RUN && VALUE(i + run) == v) run++;
+        if (run >= 3) {
+            put(FRAMESTREAM_REPEAT | (run - 1));
+            put(v);
+            i += run;
+            continue;
+        }
+
+        // Literal: up to the next zero or run of three
+        int start = i;
+        int n = 0;
+        while (i < len && n < FRAMESTREAM_MAX_RUN && VALUE(i) != 0 &&
+               !(i + 2 < len && VALUE(i + 1) == VALUE(i) && VALUE(i + 2) == VALUE(i))) {
+            i++;
+            n++;
+        }
+        put(FRAMESTREAM_LITERAL | (n - 1));
+        for (int k = start; k < start + n; k++) put(VALUE(k));
+    }
+    fs.col += len;
+#undef VALUE
+}
+
+// Finish the open packet: the columns after the last span are unchanged
+static void close_page(void) {
+    fs.zeros += FRAMESTREAM_PAGE_BYTES - fs.col;
+    put_zeros();
+    packet_end();
+    fs.open = false;
+}
+
+// ============================================================================
+// ENCODER
+// ============================================================================
+
+void framestream_delta(uint8_t addr, int page, int col, const uint8_t *old, const uint8_t *cur, int len) {
+    if (!fs.write) return;
+    xSemaphoreTake(fs.lock, portMAX_DELAY);
+    if (fs.write) {
+        if (fs.open && (fs.addr != addr || fs.page != page || col < fs.col)) close_page();
+        
+        // Spans that change nothing (single-shot flushes send every
+        // page) don't open a packet
+        bool changed = fs.open;
+        for (int i = 0; i < len && !changed; i++) changed = (old[i] != cur[i]);
+        
+        if (changed) {
+            if (!fs.open) {
+                packet_begin(FRAMESTREAM_DELTA, addr, page);
+                fs.open = true;
+                fs.addr = addr;
+                fs.page = page;
+                fs.col = 0;
+                fs.zeros = 0;
+            }
+            fs.zeros += col - fs.col;
+            fs.col = col;
+            put_bytes(old, cur, len);
+        }
+    }
+    xSemaphoreGive(fs.lock);
+}
+
+void framestream_page_end(void) {
+    if (!fs.write) return;
+    xSemaphoreTake(fs.lock, portMAX_DELAY);
+    if (fs.write && fs.open) close_page();
+    xSemaphoreGive(fs.lock);
+}
+
+void framestream_key(uint8_t addr, int page, const uint8_t *cur) {
+    if (!fs.write) return;
+    xSemaphoreTake(fs.lock, portMAX_DELAY);
+    if (fs.write) {
+        if (fs.open) close_page();
+        packet_begin(FRAMESTREAM_KEY, addr, page);
+        fs.col = 0;
+        fs.zeros = 0;
+        put_bytes(NULL, cur, FRAMESTREAM_PAGE_BYTES);
+        put_zeros();
+        packet_end();
+    }
+    xSemaphoreGive(fs.lock);
+}
+
+void framestream_frame_end(uint8_t addr, bool key) {
+    if (!fs.write) return;
+    xSemaphoreTake(fs.lock, portMAX_DELAY);
+    if (fs.write) {
+        if (fs.open) close_page();
+        packet_begin(FRAMESTREAM_FRAME, addr, 0);
+        packet_end();
+        fs.stats.frames++;
+        if (key) fs.stats.key_frames++;
+    }
+    xSemaphoreGive(fs.lock);
+}
+
+// ============================================================================
+// SINKS
+// ============================================================================
+
+static void file_write(const uint8_t *data, size_t len, void *ctx) {
+    FILE *f = ctx;
+    fwrite(data, 1, len, f);
+    fflush(f);      // Keep a reader on the other end of a pipe in step
+}
+
+#if !SSD1306_HOST_BUS
+static void uart_write(const uint8_t *data, size_t len, void *ctx) {
+    uart_write_bytes((uart_port_t)(intptr_t)ctx, data, len);
+}
+#endif
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+
+// Swap in a new sink, closing the old stream's open packet and file
+static esp_err_t set_sink(framestream_write_fn write, void *ctx, FILE *file) {
+    if (!fs.lock) {
+        fs.lock = xSemaphoreCreateMutex();
+        if (!fs.lock) return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(fs.lock, portMAX_DELAY);
+    if (fs.write && fs.open) close_page();
+    if (fs.file && fs.file != stdout) fclose(fs.file);
+    fs.write = write;
+    fs.ctx = ctx;
+    fs.file = file;
+    fs.open = false;
+    fs.out_len = 0;
+    if (write) {
+        fs.epoch++;
+        memset(&fs.stats, 0, sizeof(fs.stats));
+    }
+    xSemaphoreGive(fs.lock);
+    return ESP_OK;
+}
+
+esp_err_t framestream_start(framestream_write_fn write, void *ctx) {
+    if (!write) return ESP_ERR_INVALID_ARG;
+    return set_sink(write, ctx, NULL);
+}
+
+esp_err_t framestream_start_uart(int uart_port, int tx_pin, int baud) {
+#if SSD1306_HOST_BUS
+    (void)uart_port;
+    (void)tx_pin;
+    (void)baud;
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    const uart_config_t config = {
+        .baud_rate = baud,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    esp_err_t ret = ESP_OK;
+    if (!uart_is_driver_installed(uart_port)) {
+        // The driver wants a receive buffer even though nothing is read
+        ret = uart_driver_install(uart_port, UART_HW_FIFO_LEN(uart_port) * 2,
+                                  FRAMESTREAM_UART_TX_BUFFER, 0, NULL, 0);
+    }
+    if (ret == ESP_OK) ret = uart_param_config(uart_port, &config);
+    if (ret == ESP_OK) {
+        ret = uart_set_pin(uart_port, tx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE,
+                           UART_PIN_NO_CHANGE);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set up UART%d: %s", uart_port, esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Streaming frames on UART%d (TX=%d, %d baud)", uart_port, tx_pin, baud);
+    return set_sink(uart_write, (void *)(intptr_t)uart_port, NULL);
+#endif
+}
+
+esp_err_t framestream_start_file(const char *path) {
+    if (!path) return ESP_ERR_INVALID_ARG;
+
+    FILE *f = (strcmp(path, "-") == 0) ? stdout : fopen(path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Can't open %s", path);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Streaming frames to %s", path);
+    esp_err_t ret = set_sink(file_write, f, f);
+    if (ret != ESP_OK && f != stdout) fclose(f);
+    return ret;
+}
+
+void framestream_stop(void) {
+    if (fs.lock) set_sink(NULL, NULL, NULL);
+}
+
+bool framestream_active(void) {
+    return fs.write != NULL;
+}
+
+uint32_t framestream_epoch(void) {
+    return fs.epoch;
+}
+
+void framestream_get_stats(framestream_stats_t *stats) {
+    if (!stats) return;
+    if (!fs.lock) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    xSemaphoreTake(fs.lock, portMAX_DELAY);
+    *stats = fs.stats;
+    xSemaphoreGive(fs.lock);
+}
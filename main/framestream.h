@@ -0,0 +1,115 @@
+/*
+ * Frame Stream
+ * Mirrors what the SSD1306 panels show over a UART or any byte stream, as
+ * run-length coded page deltas (see framestream_format.h), for watching a
+ * unit in the field with tools/framestream_decode
+ */
+
+#ifndef FRAMESTREAM_H
+#define FRAMESTREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// Frames between key frames, which let a decoder that joined late or
+// lost bytes catch up. Each panel also sends one first thing after
+// framestream_start().
+#ifndef FRAMESTREAM_KEYFRAME_INTERVAL
+#define FRAMESTREAM_KEYFRAME_INTERVAL  100
+#endif
+
+// UART driver transmit buffer for framestream_start_uart()
+#ifndef FRAMESTREAM_UART_TX_BUFFER
+#define FRAMESTREAM_UART_TX_BUFFER  4096
+#endif
+
+// Sink for encoded bytes. Called with at most a few dozen bytes at a
+// time, from whichever task is flushing the panel. May block; the flush
+// waits for it.
+typedef void (*framestream_write_fn)(const uint8_t *data, size_t len, void *ctx);
+
+typedef struct {
+    uint32_t frames;            // Frames streamed (all panels)
+    uint32_t key_frames;        // Of which key frames
+    uint32_t packets;
+    uint64_t bytes;             // Encoded bytes, packet framing included
+} framestream_stats_t;
+
+/**
+ * Start streaming to a custom sink (replaces any running stream)
+ * @return ESP_OK on success
+ */
+esp_err_t framestream_start(framestream_write_fn write, void *ctx);
+
+/**
+ * Start streaming out of a UART
+ * Installs the UART driver on the port, transmit only.
+ * @param uart_port UART to use; not the console's
+ * @param tx_pin GPIO for its TX line
+ * @param baud Line rate. The stream is a few hundred bytes per changed
+ *        frame, so use 921600 or so to keep up with the animation.
+ */
+esp_err_t framestream_start_uart(int uart_port, int tx_pin, int baud);
+
+/**
+ * Start streaming to a file or FIFO ("-" = stdout, which is the USB
+ * console on boards without a UART bridge; the decoder skips log lines
+ * between packets)
+ */
+esp_err_t framestream_start_file(const char *path);
+
+/**
+ * Stop streaming. Closes a file opened by framestream_start_file(); a
+ * UART keeps its driver.
+ */
+void framestream_stop(void);
+
+/**
+ * Whether a stream is running
+ */
+bool framestream_active(void);
+
+/**
+ * Number of the running stream, changed by every framestream_start*()
+ * Panels send a key frame when it differs from the one they last saw.
+ */
+uint32_t framestream_epoch(void);
+
+/**
+ * Get counts for the running stream
+ */
+void framestream_get_stats(framestream_stats_t *stats);
+
+// ============================================================================
+// ENCODER (called by the SSD1306 driver as it writes the panel)
+// ============================================================================
+
+/**
+ * Add columns written to a page to its delta packet
+ * Spans of one page come in column order; the packet opens on the first
+ * and stays open until framestream_page_end().
+ * @param addr Panel I2C address
+ * @param col First column written
+ * @param old What the columns held before
+ * @param cur What they hold now
+ */
+void framestream_delta(uint8_t addr, int page, int col, const uint8_t *old, const uint8_t *cur, int len);
+
+/**
+ * Close the open delta packet, if any
+ */
+void framestream_page_end(void);
+
+/**
+ * Send a whole page as a key page
+ */
+void framestream_key(uint8_t addr, int page, const uint8_t *cur);
+
+/**
+ * Mark the panel's pages sent since its last frame as a frame
+ */
+void framestream_frame_end(uint8_t addr, bool key);
+
+#endif // FRAMESTREAM_H
@@ -0,0 +1,57 @@
+/*
+ * Frame Stream Wire Format
+ * Shared by the encoder (framestream.c) and the host decoder
+ * (tools/framestream_decode.c); plain C, no IDF headers
+ *
+ * The stream is a sequence of packets:
+ *
+ *   0xA5 0x5A type seq addr arg payload check_a check_b
+ *
+ * seq counts packets (all panels, wrapping at 256) so a reader can tell
+ * when it lost one. addr is the panel's I2C address. check is a
+ * Fletcher-16 over type..payload.
+ *
+ * Page payloads are run-length coded and always cover the page's 128
+ * bytes exactly. Delta pages code the XOR against what the page held
+ * before, so unchanged columns are zero runs; key pages code the page
+ * content itself and let a reader start (or recover) from nothing.
+ */
+
+#ifndef FRAMESTREAM_FORMAT_H
+#define FRAMESTREAM_FORMAT_H
+
+#include <stdint.h>
+
+#define FRAMESTREAM_SYNC0       0xA5
+#define FRAMESTREAM_SYNC1       0x5A
+
+// Packet types
+#define FRAMESTREAM_DELTA       'D'     // arg = page, payload = XOR with the page before
+#define FRAMESTREAM_KEY         'K'     // arg = page, payload = the page
+#define FRAMESTREAM_FRAME       'F'     // arg = 0, no payload: the pages so far are a frame
+
+#define FRAMESTREAM_HEADER_BYTES    4   // type, seq, addr, arg
+#define FRAMESTREAM_PAGE_BYTES      128
+
+// Run-length tokens
+#define FRAMESTREAM_ZEROS       0x00    // 0x00-0x7F: 1-128 zero bytes
+#define FRAMESTREAM_REPEAT      0x80    // 0x80-0xBF, byte: 1-64 copies of byte
+#define FRAMESTREAM_LITERAL     0xC0    // 0xC0-0xFF, bytes: 1-64 bytes as they are
+#define FRAMESTREAM_MAX_ZEROS   128
+#define FRAMESTREAM_MAX_RUN     64
+
+// Longest page payload the encoder produces (alternating one-byte zero
+// runs and one-byte literals)
+#define FRAMESTREAM_MAX_PAYLOAD (FRAMESTREAM_PAGE_BYTES / 2 * 3)
+
+// Fletcher-16 running sums
+typedef struct {
+    uint8_t a, b;
+} framestream_check_t;
+
+static inline void framestream_check_add(framestream_check_t *check, uint8_t byte) {
+    check->a = (uint8_t)((check->a + byte) % 255);
+    check->b = (uint8_t)((check->b + check->a) % 255);
+}
+
+#endif // FRAMESTREAM_FORMAT_H
@@ -0,0 +1,315 @@
+/*
+ * Particle System Implementation
+ * Kernels walk one emitter's block of the pool field by field; drawing
+ * blits a pre-made stamp per particle, so the frame loop has no float
+ * math and no calls into the hardware RNG
+ */
+
+#include "particles.h"
+#include "esp_random.h"
+#include <string.h>
+
+struct particle_emitter {
+    particle_emitter_config_t config;
+    bool used;
+    bool enabled;
+    uint16_t first;             // Block of the pool
+};
+
+static particle_pool_t pool;
+static particle_emitter_t emitters[PARTICLE_MAX_EMITTERS];
+
+// Live emitters in creation order, for drawing
+static particle_emitter_t *order[PARTICLE_MAX_EMITTERS];
+static int emitter_count = 0;
+
+static particle_stats_t stats;
+static uint32_t rng = 0;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+// Quarter sine wave, 0..64 of a 256-step turn, scaled to 127
+static const uint8_t quarter_sin[65] = {
+    0, 3, 6, 9, 12, 16, 19, 22, 25, 28, 31, 34, 37, 40, 43, 46,
+    49, 51, 54, 57, 60, 63, 65, 68, 71, 73, 76, 78, 81, 83, 85, 88,
+    90, 92, 94, 96, 98, 100, 102, 104, 106, 107, 109, 111, 112, 113, 115, 116,
+    117, 118, 120, 121, 122, 122, 123, 124, 125, 125, 126, 126, 126, 127, 127, 127,
+    127,
+};
+
+int8_t particle_sin(uint8_t phase) {
+    uint8_t q = phase & 63;
+    int v;
+    switch (phase >> 6) {
+        case 0:  v = quarter_sin[q]; break;
+        case 1:  v = quarter_sin[64 - q]; break;
+        case 2:  v = -quarter_sin[q]; break;
+        default: v = -quarter_sin[64 - q]; break;
+    }
+    return (int8_t)v;
+}
+
+// xorshift32, seeded once from the hardware RNG
+static inline uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static inline int random_range(int lo, int hi) {
+    if (hi <= lo) return lo;
+    return lo + (int)(next_random() % (uint32_t)(hi - lo + 1));
+}
+
+static void place_in(int i, const particle_rect_t *r) {
+    int x = r->x + ((r->w > 1) ? (int)(next_random() % (uint32_t)r->w) : 0);
+    int y = r->y + ((r->h > 1) ? (int)(next_random() % (uint32_t)r->h) : 0);
+    pool.x[i] = (int16_t)(x * PARTICLE_ONE);
+    pool.y[i] = (int16_t)(y * PARTICLE_ONE);
+}
+
+void particle_respawn(particle_emitter_t *em, int i) {
+    const particle_emitter_config_t *c = &em->config;
+    place_in(i, &c->spawn);
+    pool.vx[i] = (int16_t)random_range(c->vx_min, c->vx_max);
+    pool.vy[i] = (int16_t)random_range(c->vy_min, c->vy_max);
+    pool.life[i] = (uint16_t)random_range(c->life_min, c->life_max);
+    pool.phase[i] = (uint8_t)next_random();
+    pool.rate[i] = (uint8_t)random_range(c->rate_min, c->rate_max);
+    pool.size[i] = (uint8_t)random_range(c->size_min, c->size_max);
+    stats.respawned++;
+}
+
+// Live area, in particle units: the screen plus the emitter's margin
+typedef struct {
+    int left, top, right, bottom;
+} bounds_t;
+
+static bounds_t live_bounds(const particle_emitter_t *em) {
+    int margin = em->config.margin * PARTICLE_ONE;
+    return (bounds_t){
+        .left = -margin,
+        .top = -margin,
+        .right = ssd1306_get_width() * PARTICLE_ONE + margin,
+        .bottom = ssd1306_get_height() * PARTICLE_ONE + margin,
+    };
+}
+
+// Whether a particle is done: its life ran out, or it left the live area
+// on the side it is heading for
+static inline bool finished(particle_pool_t *p, int i, const bounds_t *b) {
+    if (p->life[i] != 0 && --p->life[i] == 0) return true;
+    return (p->vy[i] > 0 && p->y[i] > b->bottom) || (p->vy[i] < 0 && p->y[i] < b->top) ||
+           (p->vx[i] > 0 && p->x[i] > b->right) || (p->vx[i] < 0 && p->x[i] < b->left);
+}
+
+// ============================================================================
+// KERNELS
+// ============================================================================
+
+// Straight lines at constant speed (falling stars, snow, sparkles)
+void particle_kernel_drift(particle_emitter_t *em, particle_pool_t *p, int first, int count) {
+    bounds_t bounds = live_bounds(em);
+    for (int i = first; i < first + count; i++) {
+        p->x[i] += p->vx[i];
+        p->y[i] += p->vy[i];
+        p->phase[i] += p->rate[i];
+        if (finished(p, i, &bounds)) particle_respawn(em, i);
+    }
+}
+
+// Vertical drift, weaving side to side with the phase (floating hearts)
+void particle_kernel_sway(particle_emitter_t *em, particle_pool_t *p, int first, int count) {
+    bounds_t bounds = live_bounds(em);
+    int sway = em->config.sway;
+    for (int i = first; i < first + count; i++) {
+        p->x[i] += (int16_t)(particle_sin(p->phase[i]) * sway / 127);
+        p->y[i] += p->vy[i];
+        p->phase[i] += p->rate[i];
+        if (finished(p, i, &bounds)) particle_respawn(em, i);
+    }
+}
+
+// Thrown and pulled down by gravity (confetti, tears)
+void particle_kernel_ballistic(particle_emitter_t *em, particle_pool_t *p, int first, int count) {
+    bounds_t bounds = live_bounds(em);
+    int16_t gravity = em->config.gravity;
+    for (int i = first; i < first + count; i++) {
+        p->vy[i] += gravity;
+        p->x[i] += p->vx[i];
+        p->y[i] += p->vy[i];
+        p->phase[i] += p->rate[i];
+        if (finished(p, i, &bounds)) particle_respawn(em, i);
+    }
+}
+
+// ============================================================================
+// EMITTERS
+// ============================================================================
+
+// First free block of count particles, or -1
+static int find_block(int count) {
+    int start = 0;
+    for (;;) {
+        if (start + count > PARTICLE_MAX) return -1;
+
+        // Move past any emitter overlapping [start, start + count)
+        int next = start;
+        for (int e = 0; e < PARTICLE_MAX_EMITTERS; e++) {
+            const particle_emitter_t *em = &emitters[e];
+            int end = em->first + em->config.count;
+            if (em->used && em->first < start + count && end > start && end > next) next = end;
+        }
+        if (next == start) return start;
+        start = next;
+    }
+}
+
+particle_emitter_t *particle_emitter_create(const particle_emitter_config_t *config) {
+    if (!config || config->count == 0) return NULL;
+
+    particle_emitter_t *em = NULL;
+    for (int e = 0; e < PARTICLE_MAX_EMITTERS && !em; e++) {
+        if (!emitters[e].used) em = &emitters[e];
+    }
+    int first = find_block(config->count);
+    if (!em || first < 0) return NULL;
+
+    while (rng == 0) rng = esp_random();
+
+    em->config = *config;
+    if (!em->config.update) em->config.update = particle_kernel_drift;
+    em->used = true;
+    em->enabled = false;
+    em->first = (uint16_t)first;
+    order[emitter_count++] = em;
+    particle_emitter_reset(em);
+    return em;
+}
+
+void particle_emitter_destroy(particle_emitter_t *em) {
+    if (!em || !em->used) return;
+    em->used = false;
+    em->enabled = false;
+    for (int k = 0; k < emitter_count; k++) {
+        if (order[k] != em) continue;
+        memmove(&order[k], &order[k + 1], (emitter_count - k - 1) * sizeof(order[0]));
+        emitter_count--;
+        break;
+    }
+}
+
+void particle_emitter_enable(particle_emitter_t *em, bool enabled) {
+    if (em) em->enabled = enabled;
+}
+
+bool particle_emitter_enabled(const particle_emitter_t *em) {
+    return em && em->enabled;
+}
+
+void particle_emitter_reset(particle_emitter_t *em) {
+    if (!em) return;
+    const particle_rect_t *start = (em->config.start.w > 0) ? &em->config.start : NULL;
+    for (int i = em->first; i < em->first + em->config.count; i++) {
+        particle_respawn(em, i);
+        if (start) place_in(i, start);
+    }
+}
+
+const particle_emitter_config_t *particle_emitter_config(const particle_emitter_t *em) {
+    return &em->config;
+}
+
+// ============================================================================
+// FRAME STEPS
+// ============================================================================
+
+void particles_update(void) {
+    for (int k = 0; k < emitter_count; k++) {
+        particle_emitter_t *em = order[k];
+        if (!em->enabled) continue;
+        em->config.update(em, &pool, em->first, em->config.count);
+        stats.updated += em->config.count;
+    }
+}
+
+// Stamp for particle i, or NULL if it's off screen
+static const bitmap_t *stamp_at(const particle_emitter_t *em, int i, int width, int height,
+                                int *x, int *y) {
+    const particle_shape_t *shape = em->config.shape;
+    int angles = shape->angles ? shape->angles : 1;
+    int s = (pool.size[i] < shape->sizes) ? pool.size[i] : shape->sizes - 1;
+    const bitmap_t *stamp = &shape->stamps[s * angles + ((pool.phase[i] * angles) >> 8)];
+    *x = (pool.x[i] >> PARTICLE_FRAC_BITS) - stamp->width / 2;
+    *y = (pool.y[i] >> PARTICLE_FRAC_BITS) - stamp->height / 2;
+    if (*x >= width || *y >= height || *x + stamp->width <= 0 || *y + stamp->height <= 0) return NULL;
+    return stamp;
+}
+
+static inline bool has_stamps(const particle_emitter_t *em) {
+    const particle_shape_t *shape = em->config.shape;
+    return shape && shape->stamps && shape->sizes > 0;
+}
+
+void particle_emitter_draw(const particle_emitter_t *em) {
+    if (!has_stamps(em)) return;
+
+    int width = ssd1306_get_width();
+    int height = ssd1306_get_height();
+    ssd1306_rop_t rop = em->config.rop;
+    for (int i = em->first; i < em->first + em->config.count; i++) {
+        int x, y;
+        const bitmap_t *stamp = stamp_at(em, i, width, height, &x, &y);
+        if (!stamp) continue;
+
+        ssd1306_blit(stamp, x, y, rop);
+        stats.drawn++;
+    }
+}
+
+int particle_emitter_stamps(const particle_emitter_t *em, particle_stamp_t *out, int max) {
+    if (!has_stamps(em)) return 0;
+
+    int width = ssd1306_get_width();
+    int height = ssd1306_get_height();
+    int n = 0;
+    for (int i = em->first; i < em->first + em->config.count && n < max; i++) {
+        int x, y;
+        const bitmap_t *stamp = stamp_at(em, i, width, height, &x, &y);
+        if (!stamp) continue;
+
+        out[n++] = (particle_stamp_t){stamp, (int16_t)x, (int16_t)y, (uint16_t)i};
+    }
+    return n;
+}
+
+void particles_draw(void) {
+    for (int k = 0; k < emitter_count; k++) {
+        if (order[k]->enabled) particle_emitter_draw(order[k]);
+    }
+}
+
+void particles_get_stats(particle_stats_t *out) {
+    if (out) *out = stats;
+}
+
+// ============================================================================
+// BUILT-IN SHAPES
+// ============================================================================
+
+static const uint8_t dot_data[] = {0x01};
+static const uint8_t plus_data[] = {0x02, 0x07, 0x02};
+static const uint8_t cross_data[] = {0x04, 0x04, 0x1F, 0x04, 0x04};
+
+static const bitmap_t dot_stamps[] = {{1, 1, dot_data}};
+static const bitmap_t plus_stamps[] = {{3, 3, plus_data}};
+static const bitmap_t twinkle_stamps[] = {
+    {1, 1, dot_data}, {3, 3, plus_data}, {5, 5, cross_data}, {3, 3, plus_data},
+};
+
+const particle_shape_t particle_shape_dot = {dot_stamps, 1, 1};
+const particle_shape_t particle_shape_plus = {plus_stamps, 1, 1};
+const particle_shape_t particle_shape_twinkle = {twinkle_stamps, 1, 4};
@@ -0,0 +1,197 @@
+/*
+ * Particle System
+ * Fixed-point particles for overlay effects (stars, hearts, snow,
+ * confetti, sparkles, tears), kept as structure-of-arrays in one pool and
+ * driven by emitters that each own a block of it
+ */
+
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+
+// ============================================================================
+// BUILD CONFIGURATION
+// ============================================================================
+
+// Particles shared by all emitters (13 bytes each)
+#ifndef PARTICLE_MAX
+#define PARTICLE_MAX  512
+#endif
+
+#ifndef PARTICLE_MAX_EMITTERS
+#define PARTICLE_MAX_EMITTERS  8
+#endif
+
+// Positions and velocities are in 1/64 pixel, so an int16_t spans
+// +-512 pixels
+#define PARTICLE_FRAC_BITS  6
+#define PARTICLE_ONE        (1 << PARTICLE_FRAC_BITS)
+
+// Pixels (may be fractional, for constants) to particle units
+#define PARTICLE_FX(px)     ((int16_t)((px) * PARTICLE_ONE))
+
+// ============================================================================
+// TYPES
+// ============================================================================
+
+// Particle storage. Exposed for custom update kernels; fields are indexed
+// by particle, and an emitter's particles are first..first + count - 1.
+typedef struct {
+    int16_t x[PARTICLE_MAX];        // Center, 1/64 pixel
+    int16_t y[PARTICLE_MAX];
+    int16_t vx[PARTICLE_MAX];       // 1/64 pixel per frame
+    int16_t vy[PARTICLE_MAX];
+    uint16_t life[PARTICLE_MAX];    // Frames left, 0 = until it leaves the screen
+    uint8_t phase[PARTICLE_MAX];    // Animation phase, 256 = one cycle
+    uint8_t rate[PARTICLE_MAX];     // Phase step per frame
+    uint8_t size[PARTICLE_MAX];     // Shape size index
+} particle_pool_t;
+
+// What particles look like: stamps for sizes x angles, size-major.
+// Each stamp is centered on the particle (odd width and height). The
+// angle stamp follows the particle's phase, so phase 0..255 runs once
+// through the angles.
+typedef struct {
+    const bitmap_t *stamps;
+    uint8_t sizes;
+    uint8_t angles;
+} particle_shape_t;
+
+typedef struct particle_emitter particle_emitter_t;
+
+/**
+ * Update kernel: advances an emitter's particles by one frame
+ * Calls particle_respawn() for particles that are done.
+ */
+typedef void (*particle_kernel_fn)(particle_emitter_t *em, particle_pool_t *pool, int first, int count);
+
+// Built-in kernels
+void particle_kernel_drift(particle_emitter_t *em, particle_pool_t *pool, int first, int count);
+void particle_kernel_sway(particle_emitter_t *em, particle_pool_t *pool, int first, int count);
+void particle_kernel_ballistic(particle_emitter_t *em, particle_pool_t *pool, int first, int count);
+
+// Spawn rectangle, in pixels
+typedef struct {
+    int16_t x, y, w, h;
+} particle_rect_t;
+
+typedef struct {
+    particle_kernel_fn update;      // NULL = particle_kernel_drift
+    const particle_shape_t *shape;
+    ssd1306_rop_t rop;              // How stamps combine with the frame
+    uint16_t count;                 // Particles, taken from the pool
+
+    // Ranges new particles are drawn from (inclusive)
+    particle_rect_t spawn;          // Where they appear
+    particle_rect_t start;          // Where the first ones appear (w = 0: spawn)
+    int16_t vx_min, vx_max;         // 1/64 pixel per frame
+    int16_t vy_min, vy_max;
+    uint8_t rate_min, rate_max;     // Phase step per frame
+    uint8_t size_min, size_max;     // Into shape->sizes
+    uint16_t life_min, life_max;    // Frames, 0 = until off screen
+
+    // Kernel parameters
+    int16_t gravity;                // Added to vy every frame (ballistic)
+    int16_t sway;                   // Side-to-side step amplitude (sway)
+    uint8_t margin;                 // Pixels past the screen edge before respawning
+} particle_emitter_config_t;
+
+// Where a particle's stamp lands this frame
+typedef struct {
+    const bitmap_t *bitmap;
+    int16_t x, y;                   // Top left corner
+    uint16_t index;                 // Particle, into the pool
+} particle_stamp_t;
+
+typedef struct {
+    uint32_t updated;               // Particles stepped, all frames
+    uint32_t drawn;                 // Stamps drawn
+    uint32_t respawned;
+} particle_stats_t;
+
+// ============================================================================
+// EMITTERS
+// ============================================================================
+
+/**
+ * Create an emitter and spawn its particles
+ * Emitters start disabled.
+ * @return Emitter, or NULL if the emitter or particle pool is full
+ */
+particle_emitter_t *particle_emitter_create(const particle_emitter_config_t *config);
+
+/**
+ * Destroy an emitter, returning its particles to the pool
+ */
+void particle_emitter_destroy(particle_emitter_t *em);
+
+/**
+ * Turn an emitter on or off. Particles keep their state while off.
+ */
+void particle_emitter_enable(particle_emitter_t *em, bool enabled);
+
+bool particle_emitter_enabled(const particle_emitter_t *em);
+
+/**
+ * Respawn all of an emitter's particles in its start area
+ */
+void particle_emitter_reset(particle_emitter_t *em);
+
+/**
+ * Give particle i of the pool a new life from its emitter's ranges
+ * For kernels.
+ */
+void particle_respawn(particle_emitter_t *em, int i);
+
+/**
+ * Emitter's configuration, for kernel parameters
+ */
+const particle_emitter_config_t *particle_emitter_config(const particle_emitter_t *em);
+
+// ============================================================================
+// FRAME STEPS
+// ============================================================================
+
+/**
+ * Run every enabled emitter's kernel once
+ */
+void particles_update(void);
+
+/**
+ * Stamp every enabled emitter's particles into the frame buffer, in
+ * creation order
+ */
+void particles_draw(void);
+
+/**
+ * Stamp one emitter's particles
+ */
+void particle_emitter_draw(const particle_emitter_t *em);
+
+/**
+ * List where an emitter's on-screen particles would be stamped, for
+ * callers that draw them some other way (e.g. one compositor item each)
+ * @return Number of stamps written, at most max
+ */
+int particle_emitter_stamps(const particle_emitter_t *em, particle_stamp_t *out, int max);
+
+/**
+ * Get counters since boot
+ */
+void particles_get_stats(particle_stats_t *stats);
+
+/**
+ * Sine of a phase (256 = one turn), -127..127
+ */
+int8_t particle_sin(uint8_t phase);
+
+// Built-in shapes: one pixel; a 3x3 plus; a twinkle that grows from a dot
+// to a 5x5 cross and back over its phase
+extern const particle_shape_t particle_shape_dot;
+extern const particle_shape_t particle_shape_plus;
+extern const particle_shape_t particle_shape_twinkle;
+
+#endif // PARTICLES_H
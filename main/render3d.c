@@ -4,6 +4,7 @@
 
 #include "render3d.h"
 #include "ssd1306.h"
+#include "display.h"
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -43,9 +44,7 @@ void render3d_draw_line(int x0, int y0, int x1, int y1, bool on) {
     int err = dx - dy;
     
     while (1) {
-        if (x0 >= 0 && x0 < SSD1306_WIDTH && y0 >= 0 && y0 < SSD1306_HEIGHT) {
-            ssd1306_set_pixel(x0, y0, on);
-        }
+        ssd1306_set_pixel(x0, y0, on);  // Clips
         
         if (x0 == x1 && y0 == y1) break;
         
@@ -364,6 +363,12 @@ static void draw_scanline(render_ctx_t *ctx, int y,
         ix2 = ctx->width - 1;
     }
     
+#if DISPLAY_COLOR_MODE != 1
+    // One clip test per span instead of per pixel; gray mode needs the
+    // checked call, which writes both planes
+    bool inside = ssd1306_clip_contains(ix1, y, ix2 - ix1 + 1, 1) && !ssd1306_get_gray_mode();
+#endif
+    
     for (int x = ix1; x <= ix2; x++) {
         int idx = y * ctx->width + x;
         
@@ -380,7 +385,11 @@ static void draw_scanline(render_ctx_t *ctx, int y,
     #else
             bool pixel = brightness > 0.5f;
     #endif
-            ssd1306_set_pixel(x, y, pixel);
+            if (inside) {
+                ssd1306_set_pixel_unchecked(x, y, pixel);
+            } else {
+                ssd1306_set_pixel(x, y, pixel);
+            }
 #endif
         }
         z += dz;
@@ -535,10 +544,16 @@ void render3d_draw_mesh_wireframe(render_ctx_t *ctx, mesh_t *mesh) {
 
 void render3d_present(render_ctx_t *ctx) {
 #if DISPLAY_COLOR_MODE == 1
-    // For color displays, copy buffer to display here
-    // (depends on your color display driver)
+    display_frame_t frame = {
+        .format = DISPLAY_FORMAT_RGB565,
+        .width = ctx->width,
+        .height = ctx->height,
+        .pixels = ctx->colorbuffer,
+    };
+    display_flush(&frame);
 #else
-    ssd1306_update();
+    (void)ctx;
+    display_present();
 #endif
 }
 
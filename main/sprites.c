@@ -10,39 +10,76 @@
 // SPRITE RENDERING
 // ============================================================================
 
-void sprite_draw(const sprite_t *sprite, int x, int y, bool invert) {
-    if (!sprite || !sprite->data) return;
+// Sprites are stored row-major for easy authoring, but drawn with
+// ssd1306_blit() from page-packed copies made on first use
+#define SPRITE_CACHE_SLOTS      24
+#define SPRITE_CACHE_MAX_BYTES  96      // e.g. 32x24 or 24x32
+
+typedef struct {
+    const uint8_t *src;
+    uint8_t width, height;
+    uint8_t packed[SPRITE_CACHE_MAX_BYTES];
+} packed_sprite_t;
+
+static packed_sprite_t sprite_cache[SPRITE_CACHE_SLOTS];
+static int sprite_cache_used = 0;
+
+static const packed_sprite_t* sprite_lookup(const sprite_t *sprite) {
+    for (int i = 0; i < sprite_cache_used; i++) {
+        packed_sprite_t *entry = &sprite_cache[i];
+        if (entry->src == sprite->data && entry->width == sprite->width &&
+            entry->height == sprite->height) {
+            return entry;
+        }
+    }
+    
+    int size = ((sprite->height + 7) / 8) * sprite->width;
+    if (size > SPRITE_CACHE_MAX_BYTES || sprite_cache_used >= SPRITE_CACHE_SLOTS) {
+        return NULL;
+    }
+    
+    packed_sprite_t *entry = &sprite_cache[sprite_cache_used++];
+    entry->src = sprite->data;
+    entry->width = sprite->width;
+    entry->height = sprite->height;
+    ssd1306_bitmap_pack(sprite->data, sprite->width, sprite->height, entry->packed);
+    return entry;
+}
+
+// Blit a sprite; sprites that don't fit the cache are packed 8 rows at a time
+static void sprite_blit(const sprite_t *sprite, int x, int y, ssd1306_rop_t rop) {
+    const packed_sprite_t *entry = sprite_lookup(sprite);
+    if (entry) {
+        bitmap_t bmp = {entry->width, entry->height, entry->packed};
+        ssd1306_blit(&bmp, x, y, rop);
+        return;
+    }
     
     int bytes_per_row = (sprite->width + 7) / 8;
+    uint8_t strip[255];
+    for (int row = 0; row < sprite->height; row += 8) {
+        int rows = (sprite->height - row < 8) ? sprite->height - row : 8;
+        ssd1306_bitmap_pack(&sprite->data[row * bytes_per_row], sprite->width, rows, strip);
+        bitmap_t bmp = {sprite->width, rows, strip};
+        ssd1306_blit(&bmp, x, y + row, rop);
+    }
+}
+
+void sprite_draw(const sprite_t *sprite, int x, int y, bool invert) {
+    if (!sprite || !sprite->data) return;
     
-    for (int row = 0; row < sprite->height; row++) {
-        for (int col = 0; col < sprite->width; col++) {
-            int byte_idx = row * bytes_per_row + (col / 8);
-            int bit_idx = 7 - (col % 8);  // MSB first
-            bool pixel = (sprite->data[byte_idx] >> bit_idx) & 1;
-            
-            if (invert) pixel = !pixel;
-            ssd1306_set_pixel(x + col, y + row, pixel);
-        }
+    if (invert) {
+        ssd1306_fill_rect(x, y, sprite->width, sprite->height, true);
+        sprite_blit(sprite, x, y, SSD1306_ROP_ANDNOT);
+    } else {
+        sprite_blit(sprite, x, y, SSD1306_ROP_COPY);
     }
 }
 
 void sprite_draw_transparent(const sprite_t *sprite, int x, int y, bool color) {
     if (!sprite || !sprite->data) return;
     
-    int bytes_per_row = (sprite->width + 7) / 8;
-    
-    for (int row = 0; row < sprite->height; row++) {
-        for (int col = 0; col < sprite->width; col++) {
-            int byte_idx = row * bytes_per_row + (col / 8);
-            int bit_idx = 7 - (col % 8);
-            bool pixel = (sprite->data[byte_idx] >> bit_idx) & 1;
-            
-            if (pixel) {
-                ssd1306_set_pixel(x + col, y + row, color);
-            }
-        }
-    }
+    sprite_blit(sprite, x, y, color ? SSD1306_ROP_OR : SSD1306_ROP_ANDNOT);
 }
 
 void sprite_draw_face(const face_sprite_set_t *face_set, int look_x, int look_y) {
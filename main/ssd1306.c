@@ -4,18 +4,189 @@
  */
 
 #include "ssd1306.h"
-#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#if SSD1306_HOST_BUS
+#include "ssd1306_hostbus.h"
+#else
+#include "driver/i2c_master.h"
+#endif
+#if SSD1306_FRAME_STREAM
+#include "framestream.h"
+#endif
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "ssd1306";
 
-// Frame buffer: 128x64 pixels, 1 bit per pixel = 1024 bytes
-// Organized as 8 horizontal pages of 128 bytes each
-static uint8_t frame_buffer[SSD1306_WIDTH * SSD1306_HEIGHT / 8];
+#define FRAME_BYTES  (SSD1306_WIDTH * SSD1306_HEIGHT / 8)
+
+// Clip rectangle, half-open: x0 <= x < x1, y0 <= y < y1. Always lies
+// inside the screen, so clipping to it also bounds-checks.
+typedef struct {
+    int16_t x0, y0, x1, y1;
+} clip_rect_t;
+
+// A frame (or gray plane) on its way to the panel. The flush task sends
+// it one page at a time, taking turns with the other panels' jobs.
+typedef struct {
+    uint8_t *tx;                // Buffer with its 0x40 control byte
+    uint8_t dirty;              // Pages drawn since the frame before
+    uint8_t line;               // Start line it was drawn for
+    bool gray;                  // A gray mode plane slot
+    uint8_t still_dirty;        // Pages that failed and need sending again
+    bool started;               // The deadline clock is running
+    bool aborted;               // The deadline cut the job short
+    int64_t start_us;           // Bus time of the first step
+    ssd1306_stats_t stats_start;    // Panel counts at the first step
+    uint32_t pages_start;
+    uint8_t first_page;         // Page the job starts at
+    int page;                   // Steps taken, 8 = all pages looked at
+    int win_start, win_end;     // Open column window, -1 = unknown
+    int cursor_page;            // Page the panel will write next, -1 = unknown
+} flush_job_t;
+
+struct ssd1306 {
+    // Drawing state the inline accessors use; must come first (ssd1306.h)
+    ssd1306_canvas_t canvas;
+    
+    // Frame buffers: 128x64 pixels, 1 bit per pixel = 1024 bytes each
+    // Organized as 8 horizontal pages of 128 bytes each.
+    // Each is preceded by the 0x40 data control byte, so a whole frame can go
+    // out as one transaction without copying. Drawing goes to the back buffer
+    // while the flush task sends the front one.
+    uint8_t frame_tx[2][1 + FRAME_BYTES];
+    uint8_t *back_tx;
+    uint8_t *front_tx;
+    
+    // Drawing normally goes straight into back_tx. Row-major builds and the
+    // portrait canvas draw into their own buffer instead, whose drawn pages
+    // are transposed into back_tx before they are flushed.
+#if SSD1306_ROW_MAJOR
+    uint8_t row_buffer[FRAME_BYTES];
+#else
+    uint8_t *portrait_buffer;       // 64x128 canvas, allocated on first use
+#endif
+    uint8_t converted_pages;        // Transposed, not yet flushed
+    
+    // Canvas: 128x64, or 64x128 in portrait
+    int canvas_height;
+    bool portrait;
+    
+    // Shadow copy of what the panel last received, used to skip unchanged pages
+    uint8_t sent_buffer[FRAME_BYTES];
+    uint8_t stale_pages;            // Pages the shadow may not match (resent whole)
+    
+    // Gray mode: low bitplanes laid out like frame_tx (back/front, each after
+    // a 0x40 control byte), allocated while the mode is on. The slot timer
+    // queues one plane at a time for the flush task.
+    uint8_t *gray_block;
+    uint8_t *gray_back_tx;
+    uint8_t *gray_front_tx;
+    esp_timer_handle_t gray_timer;
+    uint32_t gray_slot;
+    int64_t gray_start_us;
+    ssd1306_gray_stats_t gray_stats;
+    
+    clip_rect_t clip;
+    clip_rect_t clip_stack[SSD1306_CLIP_STACK_DEPTH];
+    int clip_depth;
+    
+    // Async flush state. idle is held while the panel has a job queued or
+    // in flight; job and front_failed belong to the flush task until it
+    // gives it back.
+    SemaphoreHandle_t idle;
+    flush_job_t job;
+    uint8_t front_failed;
+    uint8_t resume_page;            // Where the last cut-short frame stopped
+    ssd1306_async_stats_t async_stats;
+    
+    // Display start line: requested for the frame being drawn, handed to the
+    // flush task along with the front buffer, and last written to the panel
+    uint8_t start_line;
+    uint8_t front_start_line;
+    uint8_t panel_start_line;
+    
+    // Pages under continuous horizontal scroll (bit N = page N)
+    uint8_t scroll_pages;
+    
+    uint32_t pages_sent;
+    uint32_t pages_skipped;
+    
+    // Transfer counts, and the last flushes (ring, newest at
+    // history_count - 1)
+    ssd1306_stats_t stats;
+#if SSD1306_STATS_HISTORY
+    ssd1306_frame_sample_t history[SSD1306_STATS_HISTORY];
+    uint32_t history_count;
+#endif
+    
+    ssd1306_flush_mode_t flush_mode;
+    
+#if SSD1306_FRAME_STREAM
+    // Frame stream: the stream this panel sent its last key frame to,
+    // frames until the next one, and whether the job in flight sent pages
+    uint32_t stream_epoch;
+    uint16_t stream_key_in;
+    bool stream_pages;
+#endif
+    
+#if !SSD1306_HOST_BUS
+    i2c_master_dev_handle_t dev_handle;
+#endif
+    uint8_t display_addr;
+    uint32_t bus_speed_hz;
+};
+
+// The panel behind the single-panel API. Usable for drawing before
+// ssd1306_init(), so it starts out the way panel_defaults() sets up the
+// others.
+static ssd1306_t default_panel = {
+    .canvas = {
+#if SSD1306_ROW_MAJOR
+        .buffer = default_panel.row_buffer,
+#else
+        .buffer = &default_panel.frame_tx[0][1],
+#endif
+        .width = SSD1306_WIDTH,
+        .dirty_pages = 0xFF,
+    },
+    .frame_tx = {{0x40}, {0x40}},
+    .back_tx = default_panel.frame_tx[0],
+    .front_tx = default_panel.frame_tx[1],
+    .canvas_height = SSD1306_HEIGHT,
+    .stale_pages = 0xFF,
+    .clip = {0, 0, SSD1306_WIDTH, SSD1306_HEIGHT},
+    .flush_mode = SSD1306_DEFAULT_FLUSH_MODE,
+    .display_addr = 0x3C,
+};
+
+ssd1306_t *const ssd1306_default = &default_panel;
+
+// The I2C bus every panel shares, and the flush task that serves them
+static struct {
+    bool ready;
+#if !SSD1306_HOST_BUS
+    i2c_master_bus_handle_t handle;
+    i2c_master_bus_config_t config;     // To recreate the controller
+#endif
+    SemaphoreHandle_t lock;         // Held by whoever is writing to a panel
+    QueueHandle_t requests;         // Panels with a job for the flush task
+    ssd1306_t *panels[SSD1306_MAX_PANELS];  // Panels set up on it
+    int panel_count;
+    
+    uint32_t failures;              // Failed transactions in a row
+    ssd1306_bus_stats_t stats;
+} bus;
+
+static void flush_task(void *arg);
 
-static i2c_master_dev_handle_t dev_handle = NULL;
-static uint8_t display_addr = 0x3C;
+// SCL rates tried by ssd1306_benchmark(), slowest first
+static const uint32_t bench_rates[SSD1306_BENCH_RATES] = {100000, 400000, 800000, 1000000};
 
 // SSD1306 commands
 #define SSD1306_CMD_DISPLAY_OFF         0xAE
@@ -36,29 +207,214 @@ static uint8_t display_addr = 0x3C;
 #define SSD1306_CMD_MEMORY_MODE         0x20
 #define SSD1306_CMD_SET_COL_ADDR        0x21
 #define SSD1306_CMD_SET_PAGE_ADDR       0x22
+#define SSD1306_CMD_SCROLL_RIGHT        0x26
+#define SSD1306_CMD_SCROLL_LEFT         0x27
+#define SSD1306_CMD_SCROLL_OFF          0x2E
+#define SSD1306_CMD_SCROLL_ON           0x2F
+
+// Wire cost model for partial flushes, in bytes. Opening a column window
+// costs one command transaction (address byte, control byte, six command
+// bytes) plus the address and control byte of the data transaction that
+// follows.
+#define WINDOW_CMD_BYTES    (2 + 6)
+#define DATA_TXN_BYTES      2
+#define WINDOW_COST_BYTES   (WINDOW_CMD_BYTES + DATA_TXN_BYTES)
+
+// Longest command stream sent in a single transaction
+#define MAX_CMD_BATCH       32
+
+// Set up a newly allocated panel like default_panel
+static void panel_defaults(ssd1306_t *dev) {
+    memset(dev, 0, sizeof(*dev));
+    dev->frame_tx[0][0] = 0x40;
+    dev->frame_tx[1][0] = 0x40;
+    dev->back_tx = dev->frame_tx[0];
+    dev->front_tx = dev->frame_tx[1];
+#if SSD1306_ROW_MAJOR
+    dev->canvas.buffer = dev->row_buffer;
+#else
+    dev->canvas.buffer = &dev->frame_tx[0][1];
+#endif
+    dev->canvas.width = SSD1306_WIDTH;
+    dev->canvas.dirty_pages = 0xFF;
+    dev->canvas_height = SSD1306_HEIGHT;
+    dev->stale_pages = 0xFF;
+    dev->clip = (clip_rect_t){0, 0, SSD1306_WIDTH, SSD1306_HEIGHT};
+    dev->flush_mode = SSD1306_DEFAULT_FLUSH_MODE;
+}
+
+// Take the panel from the flush task, waiting out any frame or gray
+// plane it is sending, and then the bus from the other panels
+static void lock_panel(ssd1306_t *dev) {
+    if (dev->idle) xSemaphoreTake(dev->idle, portMAX_DELAY);
+    if (bus.lock) xSemaphoreTake(bus.lock, portMAX_DELAY);
+}
+
+static void unlock_panel(ssd1306_t *dev) {
+    if (bus.lock) xSemaphoreGive(bus.lock);
+    if (dev->idle) xSemaphoreGive(dev->idle);
+}
+
+// Write one transaction to the panel, giving up SSD1306_I2C_TIMEOUT_MS
+// after its wire time would have run out
+static esp_err_t bus_write(ssd1306_t *dev, const uint8_t *buf, size_t len) {
+    uint32_t wire_ms = dev->bus_speed_hz ? (uint32_t)((1 + len) * 9 * 1000 / dev->bus_speed_hz) + 1 : 0;
+#if SSD1306_HOST_BUS
+    return hostbus_transmit(dev->display_addr, buf, len, SSD1306_I2C_TIMEOUT_MS + wire_ms);
+#else
+    return i2c_master_transmit(dev->dev_handle, buf, len, SSD1306_I2C_TIMEOUT_MS + wire_ms);
+#endif
+}
+
+static esp_err_t apply_bus_speed(ssd1306_t *dev, uint32_t scl_hz);
+
+// Recreate the I2C controller and re-add every panel at its clock
+static esp_err_t reset_controller(ssd1306_t *dev) {
+#if SSD1306_HOST_BUS
+    // The stand-in has no controller state to lose
+    (void)dev;
+    hostbus_bus_reset();
+    return ESP_OK;
+#else
+    // dev may be a panel still being set up, not yet on the list
+    ssd1306_t *panels[SSD1306_MAX_PANELS + 1];
+    int count = 0;
+    bool listed = false;
+    for (int i = 0; i < bus.panel_count; i++) {
+        panels[count++] = bus.panels[i];
+        listed |= (bus.panels[i] == dev);
+    }
+    if (!listed) panels[count++] = dev;
+    
+    for (int i = 0; i < count; i++) {
+        if (panels[i]->dev_handle) {
+            i2c_master_bus_rm_device(panels[i]->dev_handle);
+            panels[i]->dev_handle = NULL;
+        }
+    }
+    i2c_del_master_bus(bus.handle);
+    esp_err_t ret = i2c_new_master_bus(&bus.config, &bus.handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to recreate I2C bus: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    for (int i = 0; i < count && ret == ESP_OK; i++) {
+        ret = apply_bus_speed(panels[i], panels[i]->bus_speed_hz);
+    }
+    return ret;
+#endif
+}
+
+// Free a hung bus: nine clock pulses and a stop condition, which lets a
+// panel stuck mid-byte release SDA. If the failures carry on, start over
+// with a fresh controller.
+static void recover_bus(ssd1306_t *dev) {
+    if (bus.failures >= 2 * SSD1306_RECOVERY_THRESHOLD) {
+        ESP_LOGW(TAG, "%lu I2C failures in a row, resetting controller",
+                 (unsigned long)bus.failures);
+        bus.stats.controller_resets++;
+        if (reset_controller(dev) == ESP_OK) bus.failures = 0;
+        return;
+    }
+    
+    ESP_LOGW(TAG, "%lu I2C failures in a row, resetting bus", (unsigned long)bus.failures);
+    bus.stats.bus_resets++;
+#if SSD1306_HOST_BUS
+    hostbus_bus_reset();
+#else
+    i2c_master_bus_reset(bus.handle);
+#endif
+}
+
+// Write one transaction to the panel, counting errors and recovering the
+// bus after SSD1306_RECOVERY_THRESHOLD failures in a row. Caller must hold
+// the bus.
+static esp_err_t bus_transmit(ssd1306_t *dev, const uint8_t *buf, size_t len) {
+    esp_err_t ret = bus_write(dev, buf, len);
+    if (ret == ESP_OK) {
+        bus.failures = 0;
+        dev->stats.bytes += 1 + len;   // Address byte + payload
+        dev->stats.transactions++;
+        return ESP_OK;
+    }
+    
+    dev->stats.bus_errors++;
+    if (ret == ESP_ERR_TIMEOUT) {
+        bus.stats.timeouts++;
+    } else {
+        bus.stats.nacks++;
+    }
+    if (++bus.failures % SSD1306_RECOVERY_THRESHOLD == 0) recover_bus(dev);
+    return ret;
+}
 
 // Send a single command byte
-static esp_err_t ssd1306_send_cmd(uint8_t cmd) {
+static esp_err_t send_cmd(ssd1306_t *dev, uint8_t cmd) {
     uint8_t data[2] = {0x00, cmd};  // 0x00 = command mode
-    return i2c_master_transmit(dev_handle, data, 2, 100);
+    return bus_transmit(dev, data, 2);
 }
 
-// Send multiple command bytes
-static esp_err_t ssd1306_send_cmds(const uint8_t *cmds, size_t len) {
-    for (size_t i = 0; i < len; i++) {
-        esp_err_t ret = ssd1306_send_cmd(cmds[i]);
+// Send multiple command bytes: one control byte followed by the whole
+// command stream, so the batch costs a single start/address/stop
+static esp_err_t send_cmds(ssd1306_t *dev, const uint8_t *cmds, size_t len) {
+    uint8_t data[1 + MAX_CMD_BATCH];
+    data[0] = 0x00;  // Command mode, Co = 0: every following byte is a command
+    
+    while (len > 0) {
+        size_t n = (len > MAX_CMD_BATCH) ? MAX_CMD_BATCH : len;
+        memcpy(&data[1], cmds, n);
+        esp_err_t ret = bus_transmit(dev, data, n + 1);
         if (ret != ESP_OK) return ret;
+        cmds += n;
+        len -= n;
     }
     return ESP_OK;
 }
 
-esp_err_t ssd1306_init(int sda_pin, int scl_pin, uint8_t i2c_addr) {
-    display_addr = i2c_addr;
+// (Re)attach the panel at a new SCL rate. Caller must hold the panel
+// once it is set up.
+static esp_err_t apply_bus_speed(ssd1306_t *dev, uint32_t scl_hz) {
+#if SSD1306_HOST_BUS
+    hostbus_set_scl_hz(dev->display_addr, scl_hz);
+#else
+    // The master driver fixes the rate when a device is added
+    if (dev->dev_handle) {
+        i2c_master_bus_rm_device(dev->dev_handle);
+        dev->dev_handle = NULL;
+    }
+    i2c_device_config_t dev_config = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = dev->display_addr,
+        .scl_speed_hz = scl_hz,
+    };
+    esp_err_t ret = i2c_master_bus_add_device(bus.handle, &dev_config, &dev->dev_handle);
+    if (ret != ESP_OK) return ret;
+#endif
+    dev->bus_speed_hz = scl_hz;
+    return ESP_OK;
+}
+
+// Clock for timing transfers: the modeled wire time on the host bus, so
+// results don't depend on the machine running the emulation
+static int64_t bus_time_us(void) {
+#if SSD1306_HOST_BUS
+    return (int64_t)hostbus_get_time_us();
+#else
+    return esp_timer_get_time();
+#endif
+}
+
+// Create the bus and its flush task on the first panel's init
+static esp_err_t bus_init(int sda_pin, int scl_pin) {
+    if (bus.ready) return ESP_OK;
     
+#if SSD1306_HOST_BUS
+    ESP_LOGI(TAG, "Using host bus stand-in (SDA=%d, SCL=%d ignored)", sda_pin, scl_pin);
+    hostbus_reset();
+#else
     ESP_LOGI(TAG, "Initializing I2C bus (SDA=%d, SCL=%d)", sda_pin, scl_pin);
     
     // Initialize I2C bus
-    i2c_master_bus_handle_t bus_handle;
     i2c_master_bus_config_t bus_config = {
         .clk_source = I2C_CLK_SRC_DEFAULT,
         .i2c_port = I2C_NUM_0,
@@ -68,20 +424,43 @@ esp_err_t ssd1306_init(int sda_pin, int scl_pin, uint8_t i2c_addr) {
         .flags.enable_internal_pullup = true,
     };
     
-    esp_err_t ret = i2c_new_master_bus(&bus_config, &bus_handle);
+    bus.config = bus_config;
+    esp_err_t ret = i2c_new_master_bus(&bus.config, &bus.handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create I2C bus: %s", esp_err_to_name(ret));
         return ret;
     }
+#endif
     
-    // Add SSD1306 device
-    i2c_device_config_t dev_config = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = i2c_addr,
-        .scl_speed_hz = 400000,
-    };
+    // Background flush task for ssd1306_present_async(), shared by all panels
+    bus.lock = xSemaphoreCreateMutex();
+    bus.requests = xQueueCreate(SSD1306_MAX_PANELS, sizeof(ssd1306_t *));
+    if (!bus.lock || !bus.requests ||
+        xTaskCreate(flush_task, "ssd1306_flush", SSD1306_FLUSH_TASK_STACK, NULL,
+                    SSD1306_FLUSH_TASK_PRIO, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start flush task");
+        return ESP_ERR_NO_MEM;
+    }
+    bus.ready = true;
+    return ESP_OK;
+}
+
+static esp_err_t panel_init(ssd1306_t *dev, int sda_pin, int scl_pin, uint8_t i2c_addr) {
+    if (!dev->idle && bus.panel_count >= SSD1306_MAX_PANELS) return ESP_ERR_NO_MEM;
+    
+    esp_err_t ret = bus_init(sda_pin, scl_pin);
+    if (ret != ESP_OK) return ret;
     
-    ret = i2c_master_bus_add_device(bus_handle, &dev_config, &dev_handle);
+    dev->display_addr = i2c_addr;
+#if SSD1306_HOST_BUS
+    ret = hostbus_attach(i2c_addr);
+    if (ret != ESP_OK) return ret;
+#endif
+    
+    // Add SSD1306 device, clear of other panels' flushes and recoveries
+    xSemaphoreTake(bus.lock, portMAX_DELAY);
+    ret = apply_bus_speed(dev, SSD1306_I2C_SPEED_HZ);
+    xSemaphoreGive(bus.lock);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to add I2C device: %s", esp_err_to_name(ret));
         return ret;
@@ -109,105 +488,1595 @@ esp_err_t ssd1306_init(int sda_pin, int scl_pin, uint8_t i2c_addr) {
         SSD1306_CMD_DISPLAY_ON,         // Display on
     };
     
-    ret = ssd1306_send_cmds(init_cmds, sizeof(init_cmds));
+    // Other panels may already be flushing
+    xSemaphoreTake(bus.lock, portMAX_DELAY);
+    ret = send_cmds(dev, init_cmds, sizeof(init_cmds));
+    xSemaphoreGive(bus.lock);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize display: %s", esp_err_to_name(ret));
         return ret;
     }
     
     // Clear frame buffer and display
-    ssd1306_clear();
-    ssd1306_update();
+    ssd1306_dev_clear(dev);
+    ssd1306_dev_update(dev);
+    
+    if (!dev->idle) {
+        dev->idle = xSemaphoreCreateBinary();
+        if (!dev->idle) return ESP_ERR_NO_MEM;
+        xSemaphoreGive(dev->idle);
+        xSemaphoreTake(bus.lock, portMAX_DELAY);
+        bus.panels[bus.panel_count++] = dev;
+        xSemaphoreGive(bus.lock);
+    }
     
     ESP_LOGI(TAG, "SSD1306 initialized successfully");
     return ESP_OK;
 }
 
-void ssd1306_clear(void) {
-    memset(frame_buffer, 0, sizeof(frame_buffer));
+esp_err_t ssd1306_init(int sda_pin, int scl_pin, uint8_t i2c_addr) {
+    return panel_init(&default_panel, sda_pin, scl_pin, i2c_addr);
 }
 
-void ssd1306_fill(void) {
-    memset(frame_buffer, 0xFF, sizeof(frame_buffer));
+esp_err_t ssd1306_dev_init(ssd1306_t **out, int sda_pin, int scl_pin, uint8_t i2c_addr) {
+    if (!out) return ESP_ERR_INVALID_ARG;
+    
+    ssd1306_t *dev = malloc(sizeof(*dev));
+    if (!dev) return ESP_ERR_NO_MEM;
+    panel_defaults(dev);
+    
+    esp_err_t ret = panel_init(dev, sda_pin, scl_pin, i2c_addr);
+    if (ret != ESP_OK) {
+#if !SSD1306_HOST_BUS
+        if (dev->dev_handle) i2c_master_bus_rm_device(dev->dev_handle);
+#endif
+        free(dev);
+        return ret;
+    }
+    *out = dev;
+    return ESP_OK;
 }
 
-void ssd1306_set_pixel(int x, int y, bool on) {
-    if (x < 0 || x >= SSD1306_WIDTH || y < 0 || y >= SSD1306_HEIGHT) {
+void ssd1306_dev_clear(ssd1306_t *dev) {
+    memset(dev->canvas.buffer, 0, FRAME_BYTES);
+    if (dev->canvas.gray_plane) memset(dev->canvas.gray_plane, 0, FRAME_BYTES);
+    dev->canvas.dirty_pages = 0xFFFF;
+}
+
+void ssd1306_dev_fill(ssd1306_t *dev) {
+    memset(dev->canvas.buffer, 0xFF, FRAME_BYTES);
+    if (dev->canvas.gray_plane) memset(dev->canvas.gray_plane, 0xFF, FRAME_BYTES);
+    dev->canvas.dirty_pages = 0xFFFF;
+}
+
+bool ssd1306_dev_push_clip(ssd1306_t *dev, int x, int y, int w, int h) {
+    if (dev->clip_depth >= SSD1306_CLIP_STACK_DEPTH) return false;
+    dev->clip_stack[dev->clip_depth++] = dev->clip;
+    
+    // Intersect; an empty result collapses to a zero-size rect
+    int x0 = (x > dev->clip.x0) ? x : dev->clip.x0;
+    int y0 = (y > dev->clip.y0) ? y : dev->clip.y0;
+    int x1 = (x + w < dev->clip.x1) ? x + w : dev->clip.x1;
+    int y1 = (y + h < dev->clip.y1) ? y + h : dev->clip.y1;
+    if (x1 < x0) x1 = x0;
+    if (y1 < y0) y1 = y0;
+    dev->clip = (clip_rect_t){x0, y0, x1, y1};
+    return true;
+}
+
+void ssd1306_dev_pop_clip(ssd1306_t *dev) {
+    if (dev->clip_depth > 0) dev->clip = dev->clip_stack[--dev->clip_depth];
+}
+
+bool ssd1306_dev_clip_contains(ssd1306_t *dev, int x, int y, int w, int h) {
+    return x >= dev->clip.x0 && y >= dev->clip.y0 && x + w <= dev->clip.x1 && y + h <= dev->clip.y1;
+}
+
+// Rows of a page inside the clip rectangle, as a bit mask
+static inline uint8_t clip_page_mask(ssd1306_t *dev, int page) {
+    int top = dev->clip.y0 - page * 8;
+    int bottom = dev->clip.y1 - page * 8;
+    if (top >= 8 || bottom <= 0 || top >= bottom) return 0;
+    
+    uint8_t mask = 0xFF;
+    if (top > 0) mask &= 0xFF << top;
+    if (bottom < 8) mask &= 0xFF >> (8 - bottom);
+    return mask;
+}
+
+void ssd1306_dev_set_pixel(ssd1306_t *dev, int x, int y, bool on) {
+    if (x < dev->clip.x0 || x >= dev->clip.x1 || y < dev->clip.y0 || y >= dev->clip.y1) {
+        return;
+    }
+    if (dev->canvas.gray_plane) {
+        // Black and white set both planes alike
+        ssd1306_dev_set_pixel_gray(dev, x, y, on ? SSD1306_GRAY_WHITE : SSD1306_GRAY_BLACK);
+        return;
+    }
+    ssd1306_dev_set_pixel_unchecked(dev, x, y, on);
+}
+
+void ssd1306_dev_set_pixel_gray(ssd1306_t *dev, int x, int y, uint8_t level) {
+    if (x < dev->clip.x0 || x >= dev->clip.x1 || y < dev->clip.y0 || y >= dev->clip.y1) {
         return;
     }
     
-    // Calculate byte index and bit position
-    // Display is organized in 8 horizontal pages (8 rows of pixels each)
-    int page = y / 8;
-    int bit = y % 8;
-    int idx = page * SSD1306_WIDTH + x;
+    int idx = ssd1306_pixel_index(&dev->canvas, x, y);
+    uint8_t bit = ssd1306_pixel_bit(x, y);
+    uint8_t *hi = &dev->canvas.buffer[idx];
+    *hi = (level & 2) ? (*hi | bit) : (*hi & ~bit);
+    if (dev->canvas.gray_plane) {
+        uint8_t *lo = &dev->canvas.gray_plane[idx];
+        *lo = (level & 1) ? (*lo | bit) : (*lo & ~bit);
+    }
+    dev->canvas.dirty_pages |= 1 << (y >> 3);
+}
+
+bool ssd1306_dev_get_pixel(ssd1306_t *dev, int x, int y) {
+    if (x < 0 || x >= dev->canvas.width || y < 0 || y >= dev->canvas_height) {
+        return false;
+    }
+    
+    return (dev->canvas.buffer[ssd1306_pixel_index(&dev->canvas, x, y)] & ssd1306_pixel_bit(x, y)) != 0;
+}
+
+// Transpose an 8x8 bit block: byte r bit c of the input (row r, column c)
+// becomes byte c bit r of the output. Three rounds of masked swaps on two
+// 32-bit halves (rows 0-3 and 4-7): 1x1 blocks within 2x2, 2x2 within
+// 4x4, then the 4x4 quadrants.
+static inline void transpose8x8(const uint8_t *src, int stride, uint8_t *dst) {
+    uint32_t lo = src[0] | (src[stride] << 8) | (src[2 * stride] << 16) |
+                  ((uint32_t)src[3 * stride] << 24);
+    uint32_t hi = src[4 * stride] | (src[5 * stride] << 8) | (src[6 * stride] << 16) |
+                  ((uint32_t)src[7 * stride] << 24);
+    uint32_t t;
+    
+    t = (lo ^ (lo >> 7)) & 0x00AA00AA;
+    lo ^= t ^ (t << 7);
+    t = (hi ^ (hi >> 7)) & 0x00AA00AA;
+    hi ^= t ^ (t << 7);
+    
+    t = (lo ^ (lo >> 14)) & 0x0000CCCC;
+    lo ^= t ^ (t << 14);
+    t = (hi ^ (hi >> 14)) & 0x0000CCCC;
+    hi ^= t ^ (t << 14);
+    
+    t = ((lo >> 4) ^ hi) & 0x0F0F0F0F;
+    hi ^= t;
+    lo ^= t << 4;
+    
+    dst[0] = lo;
+    dst[1] = lo >> 8;
+    dst[2] = lo >> 16;
+    dst[3] = lo >> 24;
+    dst[4] = hi;
+    dst[5] = hi >> 8;
+    dst[6] = hi >> 16;
+    dst[7] = hi >> 24;
+}
+
+// Transpose what was drawn since the last call into back_tx and move its
+// pages from the canvas dirty mask to converted_pages. Nothing to do when
+// drawing went straight to back_tx.
+static void convert_dirty_pages(ssd1306_t *dev) {
+    if (!dev->canvas.dirty_pages) return;
+    
+#if SSD1306_ROW_MAJOR
+    for (int page = 0; page < 8; page++) {
+        if (!(dev->canvas.dirty_pages & (1 << page))) continue;
+        const uint8_t *src = &dev->row_buffer[page * 8 * SSD1306_ROW_BYTES];
+        uint8_t *dst = &dev->back_tx[1 + page * SSD1306_WIDTH];
+        for (int col = 0; col < SSD1306_ROW_BYTES; col++) {
+            transpose8x8(&src[col], SSD1306_ROW_BYTES, &dst[col * 8]);
+        }
+    }
+    dev->converted_pages |= dev->canvas.dirty_pages;
+#else
+    if (!dev->portrait) return;
+    
+    // Canvas page k (rows 8k..8k+7) becomes panel columns 8k..8k+7 on
+    // every panel page; canvas columns 8p..8p+7 land on panel page p
+    for (int k = 0; k < SSD1306_WIDTH / 8; k++) {
+        if (!(dev->canvas.dirty_pages & (1 << k))) continue;
+        const uint8_t *src = &dev->portrait_buffer[k * SSD1306_HEIGHT];
+        for (int page = 0; page < 8; page++) {
+            transpose8x8(&src[page * 8], 1, &dev->back_tx[1 + page * SSD1306_WIDTH + k * 8]);
+        }
+    }
+    dev->converted_pages = 0xFF;
+#endif
+    dev->canvas.dirty_pages = 0;
+}
+
+// Pages drawn since the last flush, with back_tx brought up to date.
+// Clears the dirty mask.
+static uint8_t take_dirty_pages(ssd1306_t *dev) {
+    convert_dirty_pages(dev);
+    uint8_t dirty = dev->converted_pages | (uint8_t)dev->canvas.dirty_pages;
+    dev->converted_pages = 0;
+    dev->canvas.dirty_pages = 0;
+    return dirty;
+}
+
+const uint8_t* ssd1306_dev_get_buffer(ssd1306_t *dev) {
+    convert_dirty_pages(dev);
+    return &dev->back_tx[1];
+}
+
+// Dirty mask for canvas pages first..last
+static inline uint16_t page_range_mask(int first, int last) {
+    return (uint16_t)((0xFFFF << first) & (0xFFFF >> (15 - last)));
+}
+
+// Gray level of a black/white drawing call
+#define GRAY_LEVEL(on)  ((on) ? SSD1306_GRAY_WHITE : SSD1306_GRAY_BLACK)
+
+// Apply a bit mask to n consecutive bytes of one page
+static inline void apply_mask(uint8_t *dst, int n, uint8_t mask, bool on) {
+    if (mask == 0xFF) {
+        memset(dst, on ? 0xFF : 0x00, n);
+    } else if (on) {
+        for (int i = 0; i < n; i++) dst[i] |= mask;
+    } else {
+        for (int i = 0; i < n; i++) dst[i] &= ~mask;
+    }
+}
+
+#if SSD1306_ROW_MAJOR
+// Fill a clipped rectangle in one plane: each row is a masked first and
+// last byte with a memset in between
+static void fill_rect_plane(ssd1306_t *dev, uint8_t *buf, int x0, int y0, int x1, int y1, bool on) {
+    int first = x0 >> 3;
+    int last = (x1 - 1) >> 3;
+    uint8_t first_mask = 0xFF << (x0 & 7);
+    uint8_t last_mask = 0xFF >> (7 - ((x1 - 1) & 7));
+    uint8_t *row = &buf[y0 * SSD1306_ROW_BYTES];
+    
+    for (int y = y0; y < y1; y++, row += SSD1306_ROW_BYTES) {
+        if (first == last) {
+            apply_mask(&row[first], 1, first_mask & last_mask, on);
+            continue;
+        }
+        apply_mask(&row[first], 1, first_mask, on);
+        memset(&row[first + 1], on ? 0xFF : 0x00, last - first - 1);
+        apply_mask(&row[last], 1, last_mask, on);
+    }
+}
+#else
+// Fill a clipped rectangle in one plane: masked top and bottom pages,
+// memset for the full pages in between
+static void fill_rect_plane(ssd1306_t *dev, uint8_t *buf, int x0, int y0, int x1, int y1, bool on) {
+    int n = x1 - x0;
+    int first_page = y0 >> 3;
+    int last_page = (y1 - 1) >> 3;
+    uint8_t top_mask = 0xFF << (y0 & 7);
+    uint8_t bottom_mask = 0xFF >> (7 - ((y1 - 1) & 7));
+    uint8_t *row = &buf[first_page * dev->canvas.width + x0];
     
-    if (on) {
-        frame_buffer[idx] |= (1 << bit);
+    if (first_page == last_page) {
+        apply_mask(row, n, top_mask & bottom_mask, on);
     } else {
-        frame_buffer[idx] &= ~(1 << bit);
+        apply_mask(row, n, top_mask, on);
+        for (int page = first_page + 1; page < last_page; page++) {
+            row += dev->canvas.width;
+            memset(row, on ? 0xFF : 0x00, n);
+        }
+        apply_mask(row + dev->canvas.width, n, bottom_mask, on);
     }
 }
+#endif
 
-bool ssd1306_get_pixel(int x, int y) {
-    if (x < 0 || x >= SSD1306_WIDTH || y < 0 || y >= SSD1306_HEIGHT) {
-        return false;
+void ssd1306_dev_fill_rect_gray(ssd1306_t *dev, int x, int y, int w, int h, uint8_t level) {
+    // Clip once, then write whole bytes in each plane
+    int x0 = (x < dev->clip.x0) ? dev->clip.x0 : x;
+    int y0 = (y < dev->clip.y0) ? dev->clip.y0 : y;
+    int x1 = (x + w > dev->clip.x1) ? dev->clip.x1 : x + w;
+    int y1 = (y + h > dev->clip.y1) ? dev->clip.y1 : y + h;
+    if (x0 >= x1 || y0 >= y1) return;
+    
+    fill_rect_plane(dev, dev->canvas.buffer, x0, y0, x1, y1, level & 2);
+    if (dev->canvas.gray_plane) {
+        fill_rect_plane(dev, dev->canvas.gray_plane, x0, y0, x1, y1, level & 1);
+    }
+    
+    int first_page = y0 >> 3;
+    int last_page = (y1 - 1) >> 3;
+    dev->canvas.dirty_pages |= page_range_mask(first_page, last_page);
+}
+
+void ssd1306_dev_fill_rect(ssd1306_t *dev, int x, int y, int w, int h, bool on) {
+    ssd1306_dev_fill_rect_gray(dev, x, y, w, h, GRAY_LEVEL(on));
+}
+
+void ssd1306_dev_hline(ssd1306_t *dev, int x, int y, int w, bool on) {
+    ssd1306_dev_fill_rect(dev, x, y, w, 1, on);
+}
+
+void ssd1306_dev_vline(ssd1306_t *dev, int x, int y, int h, bool on) {
+    ssd1306_dev_fill_rect(dev, x, y, 1, h, on);
+}
+
+void ssd1306_dev_hline_gray(ssd1306_t *dev, int x, int y, int w, uint8_t level) {
+    ssd1306_dev_fill_rect_gray(dev, x, y, w, 1, level);
+}
+
+// Write one row of a pattern span into a plane
+#if SSD1306_ROW_MAJOR
+// Pattern bit i & 7 lines up with frame buffer bit x & 7, so the pattern
+// is stored a byte at a time
+static void pattern_span_plane(ssd1306_t *dev, uint8_t *buf, int x0, int x1, int y, uint8_t pattern) {
+    uint8_t *row = &buf[y * SSD1306_ROW_BYTES];
+    for (int b = x0 >> 3; b <= (x1 - 1) >> 3; b++) {
+        uint8_t mask = 0xFF;
+        if (b == x0 >> 3) mask &= 0xFF << (x0 & 7);
+        if (b == (x1 - 1) >> 3) mask &= 0xFF >> (7 - ((x1 - 1) & 7));
+        row[b] = (row[b] & ~mask) | (pattern & mask);
+    }
+}
+#else
+static void pattern_span_plane(ssd1306_t *dev, uint8_t *buf, int x0, int x1, int y, uint8_t pattern) {
+    uint8_t bit = 1 << (y & 7);
+    uint8_t *row = &buf[(y >> 3) * dev->canvas.width];
+    for (int i = x0; i < x1; i++) {
+        if (pattern & (1 << (i & 7))) {
+            row[i] |= bit;
+        } else {
+            row[i] &= ~bit;
+        }
+    }
+}
+#endif
+
+void ssd1306_dev_hline_pattern(ssd1306_t *dev, int x, int y, int w, uint8_t pattern) {
+    if (y < dev->clip.y0 || y >= dev->clip.y1) return;
+    int x0 = (x < dev->clip.x0) ? dev->clip.x0 : x;
+    int x1 = (x + w > dev->clip.x1) ? dev->clip.x1 : x + w;
+    if (x0 >= x1) return;
+    
+    if (pattern == 0x00 || pattern == 0xFF) {
+        ssd1306_dev_fill_rect(dev, x0, y, x1 - x0, 1, pattern != 0);
+        return;
     }
     
-    int page = y / 8;
-    int bit = y % 8;
-    int idx = page * SSD1306_WIDTH + x;
+    pattern_span_plane(dev, dev->canvas.buffer, x0, x1, y, pattern);
+    if (dev->canvas.gray_plane) pattern_span_plane(dev, dev->canvas.gray_plane, x0, x1, y, pattern);
+    dev->canvas.dirty_pages |= (1 << (y >> 3));
+}
+
+// Largest supported radius (bounds the row table on the stack)
+#define MAX_ELLIPSE_RADIUS  255
+
+// Half-width of every row of an ellipse, from the exact integer test
+// dx^2 * ry^2 + dy^2 * rx^2 <= rx^2 * ry^2. The width only shrinks as |dy|
+// grows, so each row starts from the previous one (midpoint-style stepping).
+// Past a radius of 181, rx^2 * ry^2 no longer fits 32 bits, so the products
+// are taken in 64.
+static void ellipse_half_widths(int rx, int ry, int16_t *half) {
+    int64_t rx2 = (int64_t)rx * rx;
+    int64_t ry2 = (int64_t)ry * ry;
+    int64_t limit = rx2 * ry2;
+    int x = rx;
     
-    return (frame_buffer[idx] & (1 << bit)) != 0;
+    for (int dy = 0; dy <= ry; dy++) {
+        int64_t row_term = (int64_t)dy * dy * rx2;
+        while (x >= 0 && (int64_t)x * x * ry2 + row_term > limit) x--;
+        half[dy] = x;
+    }
 }
 
-void ssd1306_fill_rect(int x, int y, int w, int h, bool on) {
-    for (int j = y; j < y + h; j++) {
-        for (int i = x; i < x + w; i++) {
-            ssd1306_set_pixel(i, j, on);
+// Draw an ellipse one span per row: filled with a gray level or a
+// per-row pattern, or as a 1-pixel outline
+static void draw_ellipse_rows(ssd1306_t *dev, int cx, int cy, int rx, int ry, bool outline, uint8_t level,
+                              ssd1306_row_pattern_fn pattern, void *user) {
+    if (rx < 0 || ry < 0 || rx > MAX_ELLIPSE_RADIUS || ry > MAX_ELLIPSE_RADIUS) return;
+    if (cx + rx < dev->clip.x0 || cx - rx >= dev->clip.x1 || cy + ry < dev->clip.y0 || cy - ry >= dev->clip.y1) return;
+    
+    int16_t half[MAX_ELLIPSE_RADIUS + 1];
+    ellipse_half_widths(rx, ry, half);
+    
+    for (int dy = -ry; dy <= ry; dy++) {
+        int y = cy + dy;
+        if (y < dev->clip.y0 || y >= dev->clip.y1) continue;
+        
+        int ady = (dy < 0) ? -dy : dy;
+        int w = half[ady];
+        
+        if (outline) {
+            // Pixels not covered by the next row outward, so the outline
+            // stays connected where the edge is nearly horizontal
+            int next = (ady < ry) ? half[ady + 1] : -1;
+            int inner = (next + 1 < w) ? next + 1 : w;
+            ssd1306_dev_hline_gray(dev, cx - w, y, w - inner + 1, level);
+            ssd1306_dev_hline_gray(dev, cx + inner, y, w - inner + 1, level);
+        } else if (pattern) {
+            ssd1306_dev_hline_pattern(dev, cx - w, y, 2 * w + 1, pattern(y, user));
+        } else {
+            ssd1306_dev_hline_gray(dev, cx - w, y, 2 * w + 1, level);
         }
     }
 }
 
-void ssd1306_fill_circle(int cx, int cy, int r, bool on) {
-    for (int y = -r; y <= r; y++) {
-        for (int x = -r; x <= r; x++) {
-            if (x * x + y * y <= r * r) {
-                ssd1306_set_pixel(cx + x, cy + y, on);
+void ssd1306_dev_fill_circle(ssd1306_t *dev, int cx, int cy, int r, bool on) {
+    draw_ellipse_rows(dev, cx, cy, r, r, false, GRAY_LEVEL(on), NULL, NULL);
+}
+
+void ssd1306_dev_draw_circle(ssd1306_t *dev, int cx, int cy, int r, bool on) {
+    draw_ellipse_rows(dev, cx, cy, r, r, true, GRAY_LEVEL(on), NULL, NULL);
+}
+
+void ssd1306_dev_fill_ellipse(ssd1306_t *dev, int cx, int cy, int rx, int ry, bool on) {
+    draw_ellipse_rows(dev, cx, cy, rx, ry, false, GRAY_LEVEL(on), NULL, NULL);
+}
+
+void ssd1306_dev_fill_ellipse_gray(ssd1306_t *dev, int cx, int cy, int rx, int ry, uint8_t level) {
+    draw_ellipse_rows(dev, cx, cy, rx, ry, false, level, NULL, NULL);
+}
+
+void ssd1306_dev_fill_ellipse_pattern(ssd1306_t *dev, int cx, int cy, int rx, int ry,
+                                      ssd1306_row_pattern_fn pattern, void *user) {
+    draw_ellipse_rows(dev, cx, cy, rx, ry, false, SSD1306_GRAY_WHITE, pattern, user);
+}
+
+void ssd1306_dev_draw_ellipse(ssd1306_t *dev, int cx, int cy, int rx, int ry, bool on) {
+    draw_ellipse_rows(dev, cx, cy, rx, ry, true, GRAY_LEVEL(on), NULL, NULL);
+}
+
+// Combine one destination byte with source bits under a mask
+static inline uint8_t apply_rop(uint8_t dst, uint8_t src, uint8_t mask, ssd1306_rop_t rop) {
+    src &= mask;
+    switch (rop) {
+        case SSD1306_ROP_COPY:   return (dst & ~mask) | src;
+        case SSD1306_ROP_OR:     return dst | src;
+        case SSD1306_ROP_AND:    return dst & (src | ~mask);
+        case SSD1306_ROP_ANDNOT: return dst & ~src;
+        case SSD1306_ROP_XOR:    return dst ^ src;
+        default:                 return dst;
+    }
+}
+
+#if SSD1306_ROW_MAJOR
+// Row-major: gather each clipped source row into destination bytes, then
+// combine a byte at a time
+void ssd1306_dev_blit(ssd1306_t *dev, const bitmap_t *bmp, int x, int y, ssd1306_rop_t rop) {
+    if (!bmp || !bmp->data) return;
+    
+    int x0 = (x < dev->clip.x0) ? dev->clip.x0 : x;
+    int x1 = (x + bmp->width > dev->clip.x1) ? dev->clip.x1 : x + bmp->width;
+    int y0 = (y < dev->clip.y0) ? dev->clip.y0 : y;
+    int y1 = (y + bmp->height > dev->clip.y1) ? dev->clip.y1 : y + bmp->height;
+    if (x0 >= x1 || y0 >= y1) return;
+    
+    for (int dy = y0; dy < y1; dy++) {
+        int r = dy - y;
+        const uint8_t *src = &bmp->data[(r >> 3) * bmp->width - x];
+        uint8_t src_bit = 1 << (r & 7);
+        uint8_t *row = &dev->canvas.buffer[dy * SSD1306_ROW_BYTES];
+        
+        int dx = x0;
+        while (dx < x1) {
+            int b = dx >> 3;
+            int end = (b + 1) * 8;
+            if (end > x1) end = x1;
+            
+            uint8_t bits = 0, mask = 0;
+            for (; dx < end; dx++) {
+                uint8_t bit = 1 << (dx & 7);
+                mask |= bit;
+                if (src[dx] & src_bit) bits |= bit;
+            }
+            row[b] = apply_rop(row[b], bits, mask, rop);
+        }
+    }
+    
+    dev->canvas.dirty_pages |= page_range_mask(y0 >> 3, (y1 - 1) >> 3);
+}
+#else
+void ssd1306_dev_blit(ssd1306_t *dev, const bitmap_t *bmp, int x, int y, ssd1306_rop_t rop) {
+    if (!bmp || !bmp->data) return;
+    
+    // Clip columns once; rows are clipped per page with a bit mask
+    int col0 = (x < dev->clip.x0) ? dev->clip.x0 - x : 0;
+    int col1 = (x + bmp->width > dev->clip.x1) ? dev->clip.x1 - x : bmp->width;
+    if (col0 >= col1 || y >= dev->clip.y1 || y + bmp->height <= dev->clip.y0) return;
+    
+    // Each source page lands across two destination pages, shifted down
+    int shift = ((y % 8) + 8) % 8;
+    int base_page = (y - shift) / 8;
+    int src_pages = (bmp->height + 7) / 8;
+    
+    // Both gray planes take the same bits, keeping black and white solid
+    uint8_t *planes[2] = {dev->canvas.buffer, dev->canvas.gray_plane};
+    int plane_count = dev->canvas.gray_plane ? 2 : 1;
+    
+    for (int sp = 0; sp < src_pages; sp++) {
+        int rows = bmp->height - sp * 8;
+        uint16_t mask = (uint16_t)((rows >= 8) ? 0xFF : (0xFF >> (8 - rows))) << shift;
+        int upper = base_page + sp;
+        int lower = upper + 1;
+        uint8_t mask_upper = mask & clip_page_mask(dev, upper);
+        uint8_t mask_lower = (shift != 0) ? (mask >> 8) & clip_page_mask(dev, lower) : 0;
+        if (!mask_upper && !mask_lower) continue;
+        
+        const uint8_t *src = &bmp->data[sp * bmp->width];
+        for (int p = 0; p < plane_count; p++) {
+            uint8_t *dst_upper = mask_upper ? &planes[p][upper * dev->canvas.width] : NULL;
+            uint8_t *dst_lower = mask_lower ? &planes[p][lower * dev->canvas.width] : NULL;
+            
+            for (int c = col0; c < col1; c++) {
+                uint16_t v = (uint16_t)src[c] << shift;
+                int dx = x + c;
+                if (mask_upper) dst_upper[dx] = apply_rop(dst_upper[dx], v, mask_upper, rop);
+                if (mask_lower) dst_lower[dx] = apply_rop(dst_lower[dx], v >> 8, mask_lower, rop);
+            }
+        }
+        
+        if (mask_upper) dev->canvas.dirty_pages |= (1 << upper);
+        if (mask_lower) dev->canvas.dirty_pages |= (1 << lower);
+    }
+}
+#endif
+
+void ssd1306_bitmap_pack(const uint8_t *rows, int width, int height, uint8_t *out) {
+    int bytes_per_row = (width + 7) / 8;
+    memset(out, 0, ((height + 7) / 8) * width);
+    
+    for (int row = 0; row < height; row++) {
+        uint8_t *dst = &out[(row / 8) * width];
+        uint8_t bit = 1 << (row % 8);
+        const uint8_t *src = &rows[row * bytes_per_row];
+        for (int col = 0; col < width; col++) {
+            if (src[col / 8] & (0x80 >> (col % 8))) {
+                dst[col] |= bit;
+            }
+        }
+    }
+}
+
+// Find the changed column spans of one page. Spans separated by fewer
+// unchanged bytes than the cost of opening a new window are merged.
+// Returns the number of spans written to starts/ends.
+static int find_page_spans(const uint8_t *src, const uint8_t *shadow, bool all,
+                           uint8_t *starts, uint8_t *ends) {
+    int count = 0;
+    int col = 0;
+    
+    while (col < SSD1306_WIDTH) {
+        if (!all && src[col] == shadow[col]) {
+            col++;
+            continue;
+        }
+        
+        int end = col;
+        int gap = 0;
+        for (int c = col + 1; c < SSD1306_WIDTH; c++) {
+            if (all || src[c] != shadow[c]) {
+                end = c;
+                gap = 0;
+            } else if (++gap > WINDOW_COST_BYTES) {
+                break;
             }
         }
+        
+        starts[count] = col;
+        ends[count] = end;
+        count++;
+        col = end + 1;
+    }
+    return count;
+}
+
+// Frame stream hooks: pass each span that reached the panel, together
+// with what the shadow held there, before the shadow is updated
+#if SSD1306_FRAME_STREAM
+static void stream_span(ssd1306_t *dev, int page, int col, const uint8_t *old, const uint8_t *cur, int len) {
+    if (!framestream_active()) return;
+    framestream_delta(dev->display_addr, page, col, old, cur, len);
+    dev->stream_pages = true;
+}
+
+static void stream_page_end(void) {
+    framestream_page_end();
+}
+
+// End of a job: close the frame, as a key frame (the whole shadow) when
+// the stream is new or one is due
+static void stream_job_end(ssd1306_t *dev) {
+    if (!framestream_active()) {
+        dev->stream_pages = false;
+        return;
+    }
+    
+    bool key = (dev->stream_epoch != framestream_epoch() || dev->stream_key_in == 0);
+    if (key) {
+        for (int page = 0; page < 8; page++) {
+            framestream_key(dev->display_addr, page, &dev->sent_buffer[page * SSD1306_WIDTH]);
+        }
+        dev->stream_epoch = framestream_epoch();
+        dev->stream_key_in = FRAMESTREAM_KEYFRAME_INTERVAL;
+    } else if (dev->stream_pages) {
+        dev->stream_key_in--;
+    }
+    if (key || dev->stream_pages) framestream_frame_end(dev->display_addr, key);
+    dev->stream_pages = false;
+}
+#else
+static inline void stream_span(ssd1306_t *dev, int page, int col, const uint8_t *old, const uint8_t *cur,
+                               int len) {}
+static inline void stream_page_end(void) {}
+static inline void stream_job_end(ssd1306_t *dev) {}
+#endif
+
+// Single-shot flush: if anything changed, send the full frame as one
+// 1025-byte transaction straight out of the buffer's tx array.
+// Returns the pages that still need sending.
+static uint8_t flush_single(ssd1306_t *dev, uint8_t *tx, uint8_t dirty) {
+    const uint8_t *buf = &tx[1];
+    bool changed = (dev->stale_pages != 0);
+    for (int page = 0; page < 8 && !changed; page++) {
+        int offset = page * SSD1306_WIDTH;
+        changed = (dirty & (1 << page)) &&
+                  memcmp(&buf[offset], &dev->sent_buffer[offset], SSD1306_WIDTH) != 0;
     }
+    if (!changed) {
+        dev->pages_skipped += 8;
+        return 0;
+    }
+    
+    const uint8_t window_cmds[] = {
+        SSD1306_CMD_SET_COL_ADDR, 0, SSD1306_WIDTH - 1,
+        SSD1306_CMD_SET_PAGE_ADDR, 0, 7,
+    };
+    if (send_cmds(dev, window_cmds, sizeof(window_cmds)) != ESP_OK ||
+        bus_transmit(dev, tx, 1 + FRAME_BYTES) != ESP_OK) {
+        // Part of it may have landed: retry the whole frame next time
+        dev->stale_pages = 0xFF;
+        return 0xFF;
+    }
+    
+    for (int page = 0; page < 8; page++) {
+        int offset = page * SSD1306_WIDTH;
+        stream_span(dev, page, 0, &dev->sent_buffer[offset], &buf[offset], SSD1306_WIDTH);
+        stream_page_end();
+    }
+    memcpy(dev->sent_buffer, buf, FRAME_BYTES);
+    dev->pages_sent += 8;
+    dev->stale_pages = 0;
+    return 0;
 }
 
-void ssd1306_update(void) {
-    // Set column address range (0-127)
-    ssd1306_send_cmd(SSD1306_CMD_SET_COL_ADDR);
-    ssd1306_send_cmd(0);    // Start column
-    ssd1306_send_cmd(127);  // End column
+// Chunked flush of one page: only the changed column spans go out, each
+// under its own column/page window. A window covers pages from its start
+// to the bottom, so the next page can reuse it when its span lines up.
+// A page stops at its first failed transaction and is added to
+// job->still_dirty. Returns true if anything went out on the bus.
+static bool flush_page(ssd1306_t *dev, flush_job_t *job, int page) {
+    const uint8_t *src = &job->tx[1 + page * SSD1306_WIDTH];
+    uint8_t *shadow = &dev->sent_buffer[page * SSD1306_WIDTH];
+    
+    // The panel takes no display RAM writes while a scroll runs, in the
+    // band or out of it. Pages drawn meanwhile go out whole once it stops.
+    if (dev->scroll_pages) {
+        if (job->dirty & (1 << page)) dev->stale_pages |= (1 << page);
+        return false;
+    }
+    
+    bool stale = dev->stale_pages & (1 << page);
+    if (!stale && !(job->dirty & (1 << page))) {
+        dev->pages_skipped++;
+        return false;
+    }
     
-    // Set page address range (0-7)
-    ssd1306_send_cmd(SSD1306_CMD_SET_PAGE_ADDR);
-    ssd1306_send_cmd(0);    // Start page
-    ssd1306_send_cmd(7);    // End page
+    uint8_t starts[SSD1306_WIDTH / 2], ends[SSD1306_WIDTH / 2];
+    int spans = find_page_spans(src, shadow, stale, starts, ends);
+    if (spans == 0) {
+        dev->pages_skipped++;
+        return false;
+    }
     
-    // Send frame buffer data
-    // We need to send in chunks because I2C has buffer limits
-    // Format: 0x40 (data mode) followed by pixel data
     uint8_t chunk[129];  // 1 control byte + 128 data bytes
     chunk[0] = 0x40;     // Data mode
     
-    for (int page = 0; page < 8; page++) {
-        memcpy(&chunk[1], &frame_buffer[page * SSD1306_WIDTH], SSD1306_WIDTH);
-        i2c_master_transmit(dev_handle, chunk, 129, 100);
+    for (int i = 0; i < spans; i++) {
+        int start = starts[i];
+        int end = ends[i];
+        
+        // Widen to the open window if resending a few columns is
+        // cheaper than programming a new one
+        bool reuse = (i == 0 && job->cursor_page == page &&
+                      start >= job->win_start && end <= job->win_end &&
+                      (job->win_end - job->win_start) - (end - start) <= WINDOW_CMD_BYTES);
+        if (reuse) {
+            start = job->win_start;
+            end = job->win_end;
+        } else {
+            const uint8_t window_cmds[] = {
+                SSD1306_CMD_SET_COL_ADDR, start, end,
+                SSD1306_CMD_SET_PAGE_ADDR, page, 7,
+            };
+            if (send_cmds(dev, window_cmds, sizeof(window_cmds)) != ESP_OK) {
+                // Leave the rest of the page to the retry rather than
+                // piling more transactions on a failing bus
+                job->still_dirty |= (1 << page);
+                job->cursor_page = -1;
+                break;
+            }
+            job->win_start = start;
+            job->win_end = end;
+        }
+        
+        int len = end - start + 1;
+        memcpy(&chunk[1], &src[start], len);
+        if (bus_transmit(dev, chunk, len + 1) != ESP_OK) {
+            // Keep it dirty so the next update retries this page, and
+            // resend it whole: some of the span may have landed
+            job->still_dirty |= (1 << page);
+            dev->stale_pages |= (1 << page);
+            job->cursor_page = -1;
+            break;
+        }
+        stream_span(dev, page, start, &shadow[start], &src[start], len);
+        memcpy(&shadow[start], &src[start], len);
+        job->cursor_page = page + 1;
+    }
+    stream_page_end();
+    if (!(job->still_dirty & (1 << page))) {
+        dev->stale_pages &= ~(1 << page);
+        dev->pages_sent++;
     }
+    return true;
 }
 
-void ssd1306_set_contrast(uint8_t contrast) {
-    ssd1306_send_cmd(SSD1306_CMD_SET_CONTRAST);
-    ssd1306_send_cmd(contrast);
+static void job_begin(flush_job_t *job, uint8_t *tx, uint8_t dirty, uint8_t line, bool gray) {
+    *job = (flush_job_t){
+        .tx = tx,
+        .dirty = dirty,
+        .line = line,
+        .gray = gray,
+        .win_start = -1,
+        .win_end = -1,
+        .cursor_page = -1,
+    };
 }
 
-void ssd1306_invert(bool invert) {
-    ssd1306_send_cmd(invert ? SSD1306_CMD_INVERT_DISPLAY : SSD1306_CMD_NORMAL_DISPLAY);
+// Page a job looks at on the given step: pages go in order from the
+// first, wrapping past page 7
+static inline int job_page(const flush_job_t *job, int step) {
+    return (job->first_page + step) & 7;
 }
 
+// Send the next part of the panel's job in the current flush mode: the
+// next page with changes, or the whole frame in single mode. Once all
+// pages are done, move the start line if the frame was drawn for a
+// different one. Past SSD1306_FLUSH_DEADLINE_US from the first step, the
+// pages left (and the start line) are left for the next flush instead,
+// and the next frame starts where this one stopped, so pages that change
+// every frame can't keep the ones below them off the panel.
+// Returns false when the job is finished.
+// Caller must hold the bus.
+static bool flush_step(ssd1306_t *dev) {
+    flush_job_t *job = &dev->job;
+    
+    if (!job->started) {
+        job->started = true;
+        job->start_us = bus_time_us();
+        job->stats_start = dev->stats;
+        job->pages_start = dev->pages_sent;
+        job->first_page = job->gray ? 0 : dev->resume_page;
+    } else if (SSD1306_FLUSH_DEADLINE_US && job->page < 8 &&
+               bus_time_us() - job->start_us > SSD1306_FLUSH_DEADLINE_US) {
+        for (int step = job->page; step < 8; step++) {
+            job->still_dirty |= job->dirty & (1 << job_page(job, step));
+        }
+        if (!job->gray) dev->resume_page = job_page(job, job->page);
+        job->page = 8;
+        job->aborted = true;
+        bus.stats.deadline_aborts++;
+        return false;
+    }
+    
+    // While scrolling, the page loop holds every page back
+    if (job->page == 0 && dev->flush_mode == SSD1306_FLUSH_SINGLE && !dev->scroll_pages) {
+        job->still_dirty = flush_single(dev, job->tx, job->dirty);
+        job->page = 8;
+        return true;
+    }
+    while (job->page < 8) {
+        if (flush_page(dev, job, job_page(job, job->page++))) return true;
+    }
+    if (job->aborted) return false;
+    if (!job->gray) dev->resume_page = 0;
+    
+    // A failed write leaves panel_start_line stale, so the next flush retries
+    if (job->line != dev->panel_start_line &&
+        send_cmd(dev, SSD1306_CMD_SET_START_LINE | job->line) == ESP_OK) {
+        dev->panel_start_line = job->line;
+    }
+    return false;
+}
+
+// Account for a finished job. Caller must hold the bus.
+static void job_end(ssd1306_t *dev) {
+    flush_job_t *job = &dev->job;
+    stream_job_end(dev);
+    if (job->gray) return;
+    
+    ssd1306_stats_t *stats = &dev->stats;
+    uint32_t flush_us = (uint32_t)(bus_time_us() - job->start_us);
+    uint32_t bytes = (uint32_t)(stats->bytes - job->stats_start.bytes);
+    uint32_t pages = dev->pages_sent - job->pages_start;
+    stats->flushes++;
+    if (bytes == 0) stats->skipped_flushes++;
+    stats->flush_us_total += flush_us;
+    if (flush_us > stats->flush_us_max) stats->flush_us_max = flush_us;
+    
+#if SSD1306_STATS_HISTORY
+    uint32_t errors = stats->bus_errors - job->stats_start.bus_errors;
+    dev->history[dev->history_count++ % SSD1306_STATS_HISTORY] = (ssd1306_frame_sample_t){
+        .flush_us = flush_us,
+        .bytes = (uint16_t)(bytes > UINT16_MAX ? UINT16_MAX : bytes),
+        .transactions = (uint16_t)(stats->transactions - job->stats_start.transactions),
+        .pages = (uint8_t)pages,
+        .bus_errors = (uint8_t)(errors > UINT8_MAX ? UINT8_MAX : errors),
+    };
+#else
+    (void)pages;
+#endif
+}
+
+// Send one buffer to the panel in one go. Returns the pages that still
+// need sending. Caller must hold the panel.
+static uint8_t flush_frame(ssd1306_t *dev, uint8_t *tx, uint8_t dirty, uint8_t line) {
+    job_begin(&dev->job, tx, dirty, line, false);
+    while (flush_step(dev)) {}
+    job_end(dev);
+    return dev->job.still_dirty;
+}
+
+// How a finished job went
+static esp_err_t job_result(const flush_job_t *job) {
+    if (job->aborted) return ESP_ERR_TIMEOUT;
+    return job->still_dirty ? ESP_FAIL : ESP_OK;
+}
+
+// Serves every panel's queued jobs together, one step per panel per round,
+// so panels presented in the same frame share the bus evenly and finish
+// together instead of one waiting out the other's whole frame. Panels
+// presented mid-round join at the next round.
+static void flush_task(void *arg) {
+    ssd1306_t *active[SSD1306_MAX_PANELS];
+    int count = 0;
+    
+    while (1) {
+        ssd1306_t *dev;
+        while (count < SSD1306_MAX_PANELS &&
+               xQueueReceive(bus.requests, &dev, count ? 0 : portMAX_DELAY) == pdTRUE) {
+            active[count++] = dev;
+        }
+        
+        xSemaphoreTake(bus.lock, portMAX_DELAY);
+        for (int i = 0; i < count; ) {
+            dev = active[i];
+            if (flush_step(dev)) {
+                i++;
+                continue;
+            }
+            
+            if (dev->job.gray) {
+                // Gray plane slot: only what differs from the plane on screen
+                // goes out, so the cost is the gray areas plus new drawing.
+                // A plane cut short or failed part way never made it.
+                if (!dev->job.aborted && !dev->job.still_dirty) dev->gray_stats.planes_sent++;
+            } else {
+                dev->front_failed = dev->job.still_dirty;
+            }
+            job_end(dev);
+            active[i] = active[--count];
+            xSemaphoreGive(dev->idle);
+        }
+        xSemaphoreGive(bus.lock);
+    }
+}
+
+esp_err_t ssd1306_dev_update(ssd1306_t *dev) {
+    if (dev->gray_timer) {
+        // The slot timer does the sending
+        ssd1306_dev_present_async(dev);
+        return ESP_OK;
+    }
+    
+    // What doesn't go out is kept as panel pages: the canvas dirty mask
+    // counts canvas rows in portrait
+    lock_panel(dev);
+    uint8_t dirty = take_dirty_pages(dev) | dev->front_failed;
+    dev->front_failed = flush_frame(dev, dev->back_tx, dirty, dev->start_line);
+    esp_err_t ret = job_result(&dev->job);
+    unlock_panel(dev);
+    return ret;
+}
+
+void ssd1306_dev_present_async(ssd1306_t *dev) {
+    if (!dev->idle) {
+        // Panel not set up (init failed): fall back to a blocking update
+        ssd1306_dev_update(dev);
+        return;
+    }
+    
+    // Nothing drawn since the last present: the panel already shows it,
+    // so keep the buffers and skip the flush. A flush still running
+    // is left alone; if it fails, the next present picks its pages up.
+    // Stale pages (after a scroll or a lost transfer) and failed ones
+    // still go out. Those belong to the flush task, so they are only
+    // looked at once it is idle.
+    bool unchanged = !dev->canvas.dirty_pages && !dev->converted_pages &&
+                     dev->start_line == dev->front_start_line;
+    bool idle = (xSemaphoreTake(dev->idle, 0) == pdTRUE);
+    if (unchanged && (!idle || (!dev->stale_pages && !dev->front_failed))) {
+        if (idle) xSemaphoreGive(dev->idle);
+        dev->async_stats.skipped++;
+        return;
+    }
+    if (!idle) {
+        // Wait for the previous frame to leave the front buffer
+        int64_t t0 = esp_timer_get_time();
+        xSemaphoreTake(dev->idle, portMAX_DELAY);
+        uint32_t waited = (uint32_t)(esp_timer_get_time() - t0);
+        dev->async_stats.waits++;
+        dev->async_stats.wait_us_total += waited;
+        if (waited > dev->async_stats.wait_us_max) dev->async_stats.wait_us_max = waited;
+    }
+    dev->async_stats.presents++;
+    
+    uint8_t dirty = take_dirty_pages(dev);
+    
+    // Swap: the finished back buffer goes to the flush task, drawing
+    // continues on a copy of it so partial redraws keep working
+    uint8_t *tx = dev->front_tx;
+    dev->front_tx = dev->back_tx;
+    dev->back_tx = tx;
+    memcpy(&dev->back_tx[1], &dev->front_tx[1], FRAME_BYTES);
+#if !SSD1306_ROW_MAJOR
+    if (!dev->portrait) dev->canvas.buffer = &dev->back_tx[1];
+#endif
+    
+    if (dev->gray_timer) {
+        tx = dev->gray_front_tx;
+        dev->gray_front_tx = dev->gray_back_tx;
+        dev->gray_back_tx = tx;
+        dev->canvas.gray_plane = &dev->gray_back_tx[1];
+        memcpy(dev->canvas.gray_plane, &dev->gray_front_tx[1], FRAME_BYTES);
+    }
+    
+    dirty |= dev->front_failed;
+    dev->front_start_line = dev->start_line;
+    dev->front_failed = 0;
+    
+    if (dev->gray_timer) {
+        // The slot timer sends the planes
+        xSemaphoreGive(dev->idle);
+        return;
+    }
+    job_begin(&dev->job, dev->front_tx, dirty, dev->front_start_line, false);
+    xQueueSend(bus.requests, &dev, portMAX_DELAY);
+}
+
+void ssd1306_dev_wait_idle(ssd1306_t *dev) {
+    if (!dev->idle) return;
+    xSemaphoreTake(dev->idle, portMAX_DELAY);
+    xSemaphoreGive(dev->idle);
+}
+
+void ssd1306_dev_get_async_stats(ssd1306_t *dev, ssd1306_async_stats_t *stats) {
+    if (stats) *stats = dev->async_stats;
+}
+
+void ssd1306_dev_get_stats(ssd1306_t *dev, ssd1306_stats_t *stats) {
+    if (!stats) return;
+    if (bus.lock) xSemaphoreTake(bus.lock, portMAX_DELAY);
+    *stats = dev->stats;
+    if (bus.lock) xSemaphoreGive(bus.lock);
+}
+
+int ssd1306_dev_get_frame_samples(ssd1306_t *dev, ssd1306_frame_sample_t *samples, int max) {
+#if SSD1306_STATS_HISTORY
+    if (!samples || max <= 0) return 0;
+    if (bus.lock) xSemaphoreTake(bus.lock, portMAX_DELAY);
+    uint32_t total = dev->history_count;
+    int count = (total < SSD1306_STATS_HISTORY) ? (int)total : SSD1306_STATS_HISTORY;
+    if (count > max) count = max;
+    for (int i = 0; i < count; i++) {
+        samples[i] = dev->history[(total - count + i) % SSD1306_STATS_HISTORY];
+    }
+    if (bus.lock) xSemaphoreGive(bus.lock);
+    return count;
+#else
+    (void)dev;
+    (void)samples;
+    (void)max;
+    return 0;
+#endif
+}
+
+void ssd1306_get_bus_stats(ssd1306_bus_stats_t *stats) {
+    if (!stats) return;
+    if (bus.lock) xSemaphoreTake(bus.lock, portMAX_DELAY);
+    *stats = bus.stats;
+    if (bus.lock) xSemaphoreGive(bus.lock);
+}
+
+void ssd1306_dev_set_flush_mode(ssd1306_t *dev, ssd1306_flush_mode_t mode) {
+    dev->flush_mode = mode;
+}
+
+ssd1306_flush_mode_t ssd1306_dev_get_flush_mode(ssd1306_t *dev) {
+    return dev->flush_mode;
+}
+
+void ssd1306_dev_get_page_stats(ssd1306_t *dev, uint32_t *sent, uint32_t *skipped) {
+    if (sent) *sent = dev->pages_sent;
+    if (skipped) *skipped = dev->pages_skipped;
+}
+
+// Queue the plane for this slot: high, high, low. A slot that finds the
+// panel still busy is dropped, and it shows the previous plane longer.
+static void gray_slot_cb(void *arg) {
+    ssd1306_t *dev = arg;
+    bool low = (dev->gray_slot++ % 3 == 2);
+    // Read from other tasks by ssd1306_dev_get_gray_stats()
+    __atomic_fetch_add(&dev->gray_stats.slots, 1, __ATOMIC_RELAXED);
+    
+    if (xSemaphoreTake(dev->idle, 0) != pdTRUE) {
+        __atomic_fetch_add(&dev->gray_stats.dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    job_begin(&dev->job, low ? dev->gray_front_tx : dev->front_tx, 0xFF,
+              dev->front_start_line, true);
+    xQueueSend(bus.requests, &dev, 0);
+}
+
+esp_err_t ssd1306_dev_set_gray_mode(ssd1306_t *dev, bool enable) {
+    if (enable == (dev->gray_timer != NULL)) return ESP_OK;
+    
+    if (!enable) {
+        esp_timer_stop(dev->gray_timer);
+        xSemaphoreTake(dev->idle, portMAX_DELAY);
+        esp_timer_delete(dev->gray_timer);
+        dev->gray_timer = NULL;
+        dev->canvas.gray_plane = NULL;
+        free(dev->gray_block);
+        dev->gray_block = NULL;
+        // The panel may be showing the low plane
+        dev->canvas.dirty_pages = 0xFF;
+        xSemaphoreGive(dev->idle);
+        return ESP_OK;
+    }
+    
+    if (SSD1306_ROW_MAJOR || dev->portrait) return ESP_ERR_NOT_SUPPORTED;
+    if (!dev->idle) return ESP_ERR_INVALID_STATE;
+    
+    uint8_t *block = malloc(2 * (1 + FRAME_BYTES));
+    if (!block) return ESP_ERR_NO_MEM;
+    
+    esp_timer_handle_t timer;
+    const esp_timer_create_args_t timer_args = {
+        .callback = gray_slot_cb,
+        .arg = dev,
+        .name = "ssd1306_gray",
+    };
+    if (esp_timer_create(&timer_args, &timer) != ESP_OK) {
+        free(block);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    xSemaphoreTake(dev->idle, portMAX_DELAY);
+    
+    // The low planes start as copies of the high ones, so everything drawn
+    // so far stays black and white
+    dev->gray_block = block;
+    dev->gray_back_tx = block;
+    dev->gray_front_tx = block + 1 + FRAME_BYTES;
+    dev->gray_back_tx[0] = 0x40;
+    dev->gray_front_tx[0] = 0x40;
+    memcpy(&dev->gray_back_tx[1], &dev->back_tx[1], FRAME_BYTES);
+    memcpy(&dev->gray_front_tx[1], &dev->front_tx[1], FRAME_BYTES);
+    dev->canvas.gray_plane = &dev->gray_back_tx[1];
+    
+    memset(&dev->gray_stats, 0, sizeof(dev->gray_stats));
+    dev->gray_slot = 0;
+    dev->gray_start_us = esp_timer_get_time();
+    dev->gray_timer = timer;
+    
+    xSemaphoreGive(dev->idle);
+    
+    esp_timer_start_periodic(timer, SSD1306_GRAY_SLOT_US);
+    return ESP_OK;
+}
+
+bool ssd1306_dev_get_gray_mode(ssd1306_t *dev) {
+    return dev->gray_timer != NULL;
+}
+
+void ssd1306_dev_get_gray_stats(ssd1306_t *dev, ssd1306_gray_stats_t *stats) {
+    if (!stats) return;
+    // planes_sent is counted by the flush task under the bus lock, the
+    // others by the slot timer
+    if (bus.lock) xSemaphoreTake(bus.lock, portMAX_DELAY);
+    stats->planes_sent = dev->gray_stats.planes_sent;
+    if (bus.lock) xSemaphoreGive(bus.lock);
+    stats->slots = __atomic_load_n(&dev->gray_stats.slots, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&dev->gray_stats.dropped, __ATOMIC_RELAXED);
+    int64_t elapsed = esp_timer_get_time() - dev->gray_start_us;
+    stats->plane_rate_hz = (dev->gray_timer && elapsed > 0)
+                         ? (uint32_t)((int64_t)stats->planes_sent * 1000000 / elapsed)
+                         : 0;
+}
+
+// Scroll step intervals the panel supports, in frames, by 3-bit code
+static const uint16_t scroll_intervals[8] = {5, 64, 128, 256, 3, 4, 25, 2};
+
+static uint8_t scroll_interval_code(int frames_per_step) {
+    uint8_t best = 0;
+    for (uint8_t code = 1; code < 8; code++) {
+        if (abs(scroll_intervals[code] - frames_per_step) <
+            abs(scroll_intervals[best] - frames_per_step)) {
+            best = code;
+        }
+    }
+    return best;
+}
+
+esp_err_t ssd1306_dev_start_scroll(ssd1306_t *dev, int start_page, int end_page,
+                                   ssd1306_scroll_dir_t dir, int frames_per_step) {
+    if (start_page < 0 || end_page > 7 || start_page > end_page) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dev->scroll_pages) {
+        esp_err_t ret = ssd1306_dev_stop_scroll(dev);
+        if (ret != ESP_OK) return ret;
+    }
+    
+    uint8_t band = (uint8_t)((0xFF << start_page) & (0xFF >> (7 - end_page)));
+    
+    lock_panel(dev);
+    
+    // Put the frame on the panel first so the band scrolls what was drawn,
+    // all of it: nothing more goes out until the scroll stops, so keep
+    // going past deadline cuts
+    uint8_t dirty = take_dirty_pages(dev) | dev->front_failed;
+    int flushes = 0;
+    do {
+        dirty = flush_frame(dev, dev->back_tx, dirty, dev->start_line);
+    } while (dev->job.aborted && ++flushes < 8);
+    dev->front_failed = dirty;
+    
+    esp_err_t ret = ESP_FAIL;
+    if (!dev->job.aborted && !(dirty & band)) {
+        const uint8_t cmds[] = {
+            SSD1306_CMD_SCROLL_OFF,
+            (dir == SSD1306_SCROLL_LEFT) ? SSD1306_CMD_SCROLL_LEFT : SSD1306_CMD_SCROLL_RIGHT,
+            0x00,                               // Dummy
+            start_page,
+            scroll_interval_code(frames_per_step),
+            end_page,
+            0x00, 0xFF,                         // Dummy
+            SSD1306_CMD_SCROLL_ON,
+        };
+        ret = send_cmds(dev, cmds, sizeof(cmds));
+    }
+    if (ret == ESP_OK) {
+        dev->scroll_pages = band;
+    }
+    
+    unlock_panel(dev);
+    return ret;
+}
+
+esp_err_t ssd1306_dev_stop_scroll(ssd1306_t *dev) {
+    if (!dev->scroll_pages) return ESP_OK;
+    
+    lock_panel(dev);
+    esp_err_t ret = send_cmd(dev, SSD1306_CMD_SCROLL_OFF);
+    if (ret == ESP_OK) {
+        // Scrolling moved the band around in display RAM, so the next
+        // flush rewrites it from the frame buffer, along with any pages
+        // drawn while it ran
+        dev->stale_pages |= dev->scroll_pages;
+        dev->scroll_pages = 0;
+    }
+    unlock_panel(dev);
+    return ret;
+}
+
+uint8_t ssd1306_dev_get_scroll_pages(ssd1306_t *dev) {
+    return dev->scroll_pages;
+}
+
+void ssd1306_dev_set_vertical_offset(ssd1306_t *dev, int rows) {
+    // Display row r shows RAM row (r + start line) mod 64
+    dev->start_line = (uint8_t)(-rows) & (SSD1306_HEIGHT - 1);
+}
+
+void ssd1306_dev_get_offset_wrap(ssd1306_t *dev, int rows, int *x, int *y, int *w, int *h) {
+    // Moved down, RAM rows from 64 - rows on show at the top; moved up,
+    // RAM rows up to -rows show at the bottom
+    rows %= SSD1306_HEIGHT;
+    int first = (rows > 0) ? SSD1306_HEIGHT - rows : 0;
+    int count = (rows > 0) ? rows : -rows;
+    
+    // RAM rows are canvas rows in landscape and canvas columns in portrait
+    if (dev->portrait) {
+        *x = first;
+        *y = 0;
+        *w = count;
+        *h = count ? dev->canvas_height : 0;
+    } else {
+        *x = 0;
+        *y = first;
+        *w = count ? dev->canvas.width : 0;
+        *h = count;
+    }
+}
+
+esp_err_t ssd1306_dev_set_bus_speed(ssd1306_t *dev, uint32_t scl_hz) {
+    if (scl_hz == 0) return ESP_ERR_INVALID_ARG;
+    lock_panel(dev);
+    esp_err_t ret = apply_bus_speed(dev, scl_hz);
+    unlock_panel(dev);
+    return ret;
+}
+
+uint32_t ssd1306_dev_get_bus_speed(ssd1306_t *dev) {
+    return dev->bus_speed_hz;
+}
+
+// Time repeated writes of the first pages of a frame under a full-width
+// window, as a flush would send them. Returns the average in microseconds,
+// or 0 if any transfer failed. Failures are expected at the faster rates,
+// so they bypass the error counts and recovery.
+static uint32_t bench_transfer(ssd1306_t *dev, uint8_t *tx, int pages) {
+    const uint8_t window_cmds[] = {
+        0x00,   // Command mode
+        SSD1306_CMD_SET_COL_ADDR, 0, SSD1306_WIDTH - 1,
+        SSD1306_CMD_SET_PAGE_ADDR, 0, pages - 1,
+    };
+    
+    int64_t start = bus_time_us();
+    for (int i = 0; i < SSD1306_BENCH_REPEATS; i++) {
+        if (bus_write(dev, window_cmds, sizeof(window_cmds)) != ESP_OK ||
+            bus_write(dev, tx, 1 + pages * SSD1306_WIDTH) != ESP_OK) {
+            return 0;
+        }
+    }
+    uint32_t avg = (uint32_t)((bus_time_us() - start) / SSD1306_BENCH_REPEATS);
+    return avg ? avg : 1;
+}
+
+esp_err_t ssd1306_dev_benchmark(ssd1306_t *dev, ssd1306_bench_result_t *result, bool apply) {
+    if (!result) return ESP_ERR_INVALID_ARG;
+    if (!dev->idle) return ESP_ERR_INVALID_STATE;
+    if (dev->scroll_pages) return ESP_ERR_INVALID_STATE;     // No RAM writes while scrolling
+    
+    // Test frame: what the panel already shows, so the screen doesn't change
+    uint8_t *tx = malloc(1 + FRAME_BYTES);
+    if (!tx) return ESP_ERR_NO_MEM;
+    tx[0] = 0x40;
+    
+    memset(result, 0, sizeof(*result));
+    
+    lock_panel(dev);
+    uint32_t previous_hz = dev->bus_speed_hz;
+    memcpy(&tx[1], dev->sent_buffer, FRAME_BYTES);
+    
+    bool any_failed = false;
+    uint32_t best_us = UINT32_MAX;
+    for (int i = 0; i < SSD1306_BENCH_RATES; i++) {
+        ssd1306_bench_rate_t *rate = &result->rates[i];
+        rate->scl_hz = bench_rates[i];
+        if (apply_bus_speed(dev, rate->scl_hz) != ESP_OK) continue;
+        
+        rate->full_us = bench_transfer(dev, tx, 8);
+        rate->partial_us = rate->full_us ? bench_transfer(dev, tx, 1) : 0;
+        rate->reliable = rate->full_us && rate->partial_us;
+        any_failed |= !rate->reliable;
+        rate->frames_per_s = rate->reliable ? 1000000 / rate->full_us : 0;
+        
+        if (rate->reliable) {
+            ESP_LOGI(TAG, "SCL %4lu kHz: full frame %lu us (%lu fps), one page %lu us",
+                     (unsigned long)(rate->scl_hz / 1000), (unsigned long)rate->full_us,
+                     (unsigned long)rate->frames_per_s, (unsigned long)rate->partial_us);
+        } else {
+            ESP_LOGW(TAG, "SCL %4lu kHz: transfers failed", (unsigned long)(rate->scl_hz / 1000));
+        }
+        
+        // A faster clock only counts if it actually moves frames faster
+        if (rate->reliable && rate->full_us < best_us) {
+            best_us = rate->full_us;
+            result->selected_hz = rate->scl_hz;
+        }
+    }
+    
+    uint32_t final_hz = (apply && result->selected_hz) ? result->selected_hz : previous_hz;
+    esp_err_t ret = apply_bus_speed(dev, final_hz);
+    
+    // A failed transfer may have left the panel half written
+    if (any_failed) dev->stale_pages = 0xFF;
+    
+    unlock_panel(dev);
+    free(tx);
+    
+    if (ret != ESP_OK) return ret;
+    if (!result->selected_hz) return ESP_FAIL;
+    ESP_LOGI(TAG, "Fastest reliable SCL %lu kHz%s", (unsigned long)(result->selected_hz / 1000),
+             apply ? " (applied)" : "");
+    return ESP_OK;
+}
+
+// Segment / COM scan flips for each rotation, without and with mirroring,
+// relative to the init sequence. Portrait canvases are transposed onto the
+// panel first, which is itself a mirror image, so their flips differ.
+static const struct {
+    bool x, y;
+} orientation_flips[4][2] = {
+    [SSD1306_ROT_0]   = {{false, false}, {true,  false}},
+    [SSD1306_ROT_90]  = {{true,  false}, {true,  true }},
+    [SSD1306_ROT_180] = {{true,  true }, {false, true }},
+    [SSD1306_ROT_270] = {{false, true }, {false, false}},
+};
+
+esp_err_t ssd1306_dev_set_orientation(ssd1306_t *dev, ssd1306_orientation_t rotation, bool mirror) {
+    if (rotation > SSD1306_ROT_270) return ESP_ERR_INVALID_ARG;
+    bool want_portrait = (rotation == SSD1306_ROT_90 || rotation == SSD1306_ROT_270);
+    
+#if SSD1306_ROW_MAJOR
+    if (want_portrait) return ESP_ERR_NOT_SUPPORTED;
+#else
+    if (want_portrait && dev->gray_timer) return ESP_ERR_NOT_SUPPORTED;
+    if (want_portrait && !dev->portrait_buffer) {
+        dev->portrait_buffer = malloc(FRAME_BYTES);
+        if (!dev->portrait_buffer) return ESP_ERR_NO_MEM;
+    }
+#endif
+    
+    bool fx = orientation_flips[rotation][mirror].x;
+    bool fy = orientation_flips[rotation][mirror].y;
+    const uint8_t cmds[] = {
+        SSD1306_CMD_SET_SEG_REMAP | (fx ? 0x00 : 0x01),
+        SSD1306_CMD_SET_COM_SCAN_DIR | (fy ? 0x00 : 0x08),
+    };
+    
+    lock_panel(dev);
+    
+    esp_err_t ret = send_cmds(dev, cmds, sizeof(cmds));
+    
+    // A new canvas shape starts blank; nothing drawn carries over
+    if (ret == ESP_OK && want_portrait != dev->portrait) {
+        dev->portrait = want_portrait;
+        dev->canvas.width = dev->portrait ? SSD1306_HEIGHT : SSD1306_WIDTH;
+        dev->canvas_height = dev->portrait ? SSD1306_WIDTH : SSD1306_HEIGHT;
+#if !SSD1306_ROW_MAJOR
+        dev->canvas.buffer = dev->portrait ? dev->portrait_buffer : &dev->back_tx[1];
+#endif
+        memset(dev->canvas.buffer, 0, FRAME_BYTES);
+        dev->canvas.dirty_pages = page_range_mask(0, (dev->canvas_height >> 3) - 1);
+        dev->clip = (clip_rect_t){0, 0, dev->canvas.width, dev->canvas_height};
+        dev->clip_depth = 0;
+    }
+    
+    unlock_panel(dev);
+    return ret;
+}
+
+int ssd1306_dev_get_width(ssd1306_t *dev) {
+    return dev->canvas.width;
+}
+
+int ssd1306_dev_get_height(ssd1306_t *dev) {
+    return dev->canvas_height;
+}
+
+void ssd1306_dev_set_contrast(ssd1306_t *dev, uint8_t contrast) {
+    const uint8_t cmds[] = {SSD1306_CMD_SET_CONTRAST, contrast};
+    lock_panel(dev);
+    send_cmds(dev, cmds, sizeof(cmds));
+    unlock_panel(dev);
+}
+
+void ssd1306_dev_invert(ssd1306_t *dev, bool invert) {
+    lock_panel(dev);
+    send_cmd(dev, invert ? SSD1306_CMD_INVERT_DISPLAY : SSD1306_CMD_NORMAL_DISPLAY);
+    unlock_panel(dev);
+}
+
+
+// ============================================================================
+// SINGLE-PANEL API: the calls above on the panel from ssd1306_init()
+// ============================================================================
+
+void ssd1306_clear(void) {
+    ssd1306_dev_clear(&default_panel);
+}
+
+void ssd1306_fill(void) {
+    ssd1306_dev_fill(&default_panel);
+}
+
+bool ssd1306_push_clip(int x, int y, int w, int h) {
+    return ssd1306_dev_push_clip(&default_panel, x, y, w, h);
+}
+
+void ssd1306_pop_clip(void) {
+    ssd1306_dev_pop_clip(&default_panel);
+}
+
+bool ssd1306_clip_contains(int x, int y, int w, int h) {
+    return ssd1306_dev_clip_contains(&default_panel, x, y, w, h);
+}
+
+void ssd1306_set_pixel(int x, int y, bool on) {
+    ssd1306_dev_set_pixel(&default_panel, x, y, on);
+}
+
+void ssd1306_set_pixel_gray(int x, int y, uint8_t level) {
+    ssd1306_dev_set_pixel_gray(&default_panel, x, y, level);
+}
+
+bool ssd1306_get_pixel(int x, int y) {
+    return ssd1306_dev_get_pixel(&default_panel, x, y);
+}
+
+const uint8_t* ssd1306_get_buffer(void) {
+    return ssd1306_dev_get_buffer(&default_panel);
+}
+
+void ssd1306_fill_rect(int x, int y, int w, int h, bool on) {
+    ssd1306_dev_fill_rect(&default_panel, x, y, w, h, on);
+}
+
+void ssd1306_fill_rect_gray(int x, int y, int w, int h, uint8_t level) {
+    ssd1306_dev_fill_rect_gray(&default_panel, x, y, w, h, level);
+}
+
+void ssd1306_hline(int x, int y, int w, bool on) {
+    ssd1306_dev_hline(&default_panel, x, y, w, on);
+}
+
+void ssd1306_hline_gray(int x, int y, int w, uint8_t level) {
+    ssd1306_dev_hline_gray(&default_panel, x, y, w, level);
+}
+
+void ssd1306_vline(int x, int y, int h, bool on) {
+    ssd1306_dev_vline(&default_panel, x, y, h, on);
+}
+
+void ssd1306_hline_pattern(int x, int y, int w, uint8_t pattern) {
+    ssd1306_dev_hline_pattern(&default_panel, x, y, w, pattern);
+}
+
+void ssd1306_fill_circle(int cx, int cy, int r, bool on) {
+    ssd1306_dev_fill_circle(&default_panel, cx, cy, r, on);
+}
+
+void ssd1306_draw_circle(int cx, int cy, int r, bool on) {
+    ssd1306_dev_draw_circle(&default_panel, cx, cy, r, on);
+}
+
+void ssd1306_fill_ellipse(int cx, int cy, int rx, int ry, bool on) {
+    ssd1306_dev_fill_ellipse(&default_panel, cx, cy, rx, ry, on);
+}
+
+void ssd1306_fill_ellipse_gray(int cx, int cy, int rx, int ry, uint8_t level) {
+    ssd1306_dev_fill_ellipse_gray(&default_panel, cx, cy, rx, ry, level);
+}
+
+void ssd1306_fill_ellipse_pattern(int cx, int cy, int rx, int ry,
+                                  ssd1306_row_pattern_fn pattern, void *user) {
+    ssd1306_dev_fill_ellipse_pattern(&default_panel, cx, cy, rx, ry, pattern, user);
+}
+
+void ssd1306_draw_ellipse(int cx, int cy, int rx, int ry, bool on) {
+    ssd1306_dev_draw_ellipse(&default_panel, cx, cy, rx, ry, on);
+}
+
+void ssd1306_blit(const bitmap_t *bmp, int x, int y, ssd1306_rop_t rop) {
+    ssd1306_dev_blit(&default_panel, bmp, x, y, rop);
+}
+
+esp_err_t ssd1306_update(void) {
+    return ssd1306_dev_update(&default_panel);
+}
+
+void ssd1306_present_async(void) {
+    ssd1306_dev_present_async(&default_panel);
+}
+
+void ssd1306_wait_idle(void) {
+    ssd1306_dev_wait_idle(&default_panel);
+}
+
+void ssd1306_get_async_stats(ssd1306_async_stats_t *stats) {
+    ssd1306_dev_get_async_stats(&default_panel, stats);
+}
+
+void ssd1306_get_stats(ssd1306_stats_t *stats) {
+    ssd1306_dev_get_stats(&default_panel, stats);
+}
+
+int ssd1306_get_frame_samples(ssd1306_frame_sample_t *samples, int max) {
+    return ssd1306_dev_get_frame_samples(&default_panel, samples, max);
+}
+
+void ssd1306_set_flush_mode(ssd1306_flush_mode_t mode) {
+    ssd1306_dev_set_flush_mode(&default_panel, mode);
+}
+
+ssd1306_flush_mode_t ssd1306_get_flush_mode(void) {
+    return ssd1306_dev_get_flush_mode(&default_panel);
+}
+
+void ssd1306_get_page_stats(uint32_t *sent, uint32_t *skipped) {
+    ssd1306_dev_get_page_stats(&default_panel, sent, skipped);
+}
+
+void ssd1306_set_vertical_offset(int rows) {
+    ssd1306_dev_set_vertical_offset(&default_panel, rows);
+}
+
+void ssd1306_get_offset_wrap(int rows, int *x, int *y, int *w, int *h) {
+    ssd1306_dev_get_offset_wrap(&default_panel, rows, x, y, w, h);
+}
+
+esp_err_t ssd1306_set_gray_mode(bool enable) {
+    return ssd1306_dev_set_gray_mode(&default_panel, enable);
+}
+
+bool ssd1306_get_gray_mode(void) {
+    return ssd1306_dev_get_gray_mode(&default_panel);
+}
+
+void ssd1306_get_gray_stats(ssd1306_gray_stats_t *stats) {
+    ssd1306_dev_get_gray_stats(&default_panel, stats);
+}
+
+esp_err_t ssd1306_start_scroll(int start_page, int end_page,
+                               ssd1306_scroll_dir_t dir, int frames_per_step) {
+    return ssd1306_dev_start_scroll(&default_panel, start_page, end_page, dir, frames_per_step);
+}
+
+esp_err_t ssd1306_stop_scroll(void) {
+    return ssd1306_dev_stop_scroll(&default_panel);
+}
+
+uint8_t ssd1306_get_scroll_pages(void) {
+    return ssd1306_dev_get_scroll_pages(&default_panel);
+}
+
+esp_err_t ssd1306_set_bus_speed(uint32_t scl_hz) {
+    return ssd1306_dev_set_bus_speed(&default_panel, scl_hz);
+}
+
+uint32_t ssd1306_get_bus_speed(void) {
+    return ssd1306_dev_get_bus_speed(&default_panel);
+}
+
+esp_err_t ssd1306_benchmark(ssd1306_bench_result_t *result, bool apply) {
+    return ssd1306_dev_benchmark(&default_panel, result, apply);
+}
+
+esp_err_t ssd1306_set_orientation(ssd1306_orientation_t rotation, bool mirror) {
+    return ssd1306_dev_set_orientation(&default_panel, rotation, mirror);
+}
+
+int ssd1306_get_width(void) {
+    return ssd1306_dev_get_width(&default_panel);
+}
+
+int ssd1306_get_height(void) {
+    return ssd1306_dev_get_height(&default_panel);
+}
+
+void ssd1306_set_contrast(uint8_t contrast) {
+    ssd1306_dev_set_contrast(&default_panel, contrast);
+}
+
+void ssd1306_invert(bool invert) {
+    ssd1306_dev_invert(&default_panel, invert);
+}
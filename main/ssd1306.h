@@ -9,10 +9,214 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "sdkconfig.h"
 
 #define SSD1306_WIDTH   128
 #define SSD1306_HEIGHT  64
 
+// Bus backend: 0 = I2C master driver, 1 = host stand-in (ssd1306_hostbus.h)
+// that emulates the panel in memory and counts bytes on the wire
+#ifndef SSD1306_HOST_BUS
+#ifdef CONFIG_IDF_TARGET_LINUX
+#define SSD1306_HOST_BUS  1
+#else
+#define SSD1306_HOST_BUS  0
+#endif
+#endif
+
+// Frame buffer layout. 0 = the panel's own: pages of 8 rows, one byte per
+// column, bit 0 = top. 1 = row-major: 16 bytes per row, bit 0 = leftmost
+// pixel of each byte, so horizontal spans are whole-byte stores; dirty
+// pages are converted with an 8x8 bit transpose when flushed. Gray mode
+// needs the panel layout.
+#ifndef SSD1306_ROW_MAJOR
+#define SSD1306_ROW_MAJOR  0
+#endif
+
+#define SSD1306_ROW_BYTES  (SSD1306_WIDTH / 8)
+
+// 1 = hand what goes to the panels to framestream.h, which streams it
+// while started; 0 = leave the stream out of the flush path
+#ifndef SSD1306_FRAME_STREAM
+#define SSD1306_FRAME_STREAM  1
+#endif
+
+// 1bpp bitmap in the panel's native layout: pages of 8 rows, one byte per
+// column, bit 0 = top row of the page. Rows past height are ignored.
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+    const uint8_t *data;    // ((height + 7) / 8) * width bytes
+} bitmap_t;
+
+// Raster operations for ssd1306_blit()
+typedef enum {
+    SSD1306_ROP_COPY = 0,   // dst = src
+    SSD1306_ROP_OR,         // dst |= src   (draw source pixels white)
+    SSD1306_ROP_AND,        // dst &= src
+    SSD1306_ROP_ANDNOT,     // dst &= ~src  (draw source pixels black)
+    SSD1306_ROP_XOR,        // dst ^= src
+} ssd1306_rop_t;
+
+// Flush modes for ssd1306_update()
+typedef enum {
+    SSD1306_FLUSH_CHUNKED = 0,  // Changed spans only, one transaction per span
+    SSD1306_FLUSH_SINGLE,       // Whole frame in one 1025-byte transaction
+} ssd1306_flush_mode_t;
+
+#ifndef SSD1306_DEFAULT_FLUSH_MODE
+#define SSD1306_DEFAULT_FLUSH_MODE  SSD1306_FLUSH_CHUNKED
+#endif
+
+// Background flush task used by ssd1306_present_async()
+#ifndef SSD1306_FLUSH_TASK_PRIO
+#define SSD1306_FLUSH_TASK_PRIO   5
+#endif
+
+#ifndef SSD1306_FLUSH_TASK_STACK
+#define SSD1306_FLUSH_TASK_STACK  3072
+#endif
+
+// Panels that can share the bus (see ssd1306_dev_init())
+#ifndef SSD1306_MAX_PANELS
+#define SSD1306_MAX_PANELS  2
+#endif
+
+// I2C clock set by ssd1306_init()
+#ifndef SSD1306_I2C_SPEED_HZ
+#define SSD1306_I2C_SPEED_HZ  400000
+#endif
+
+// Time a transaction may take beyond its wire time before it is abandoned
+#ifndef SSD1306_I2C_TIMEOUT_MS
+#define SSD1306_I2C_TIMEOUT_MS  10
+#endif
+
+// Consecutive failed transactions before the bus is recovered: clock
+// pulses first, then a controller reset if failures carry on as long again
+#ifndef SSD1306_RECOVERY_THRESHOLD
+#define SSD1306_RECOVERY_THRESHOLD  3
+#endif
+
+// Bus time one flush may take before the rest of the frame is left for
+// the next one (0 = no limit). About one frame of the 8 ms animation loop:
+// a flush that keeps hitting errors stalls the next frame by no more than
+// that, and a full redraw at 400 kHz (~25 ms) goes out over a few frames.
+#ifndef SSD1306_FLUSH_DEADLINE_US
+#define SSD1306_FLUSH_DEADLINE_US  8000
+#endif
+
+// Per-frame flush samples each panel keeps for ssd1306_get_frame_samples()
+// (0 = none)
+#ifndef SSD1306_STATS_HISTORY
+#define SSD1306_STATS_HISTORY  0
+#endif
+
+// Timed transfers per size and rate in ssd1306_benchmark()
+#ifndef SSD1306_BENCH_REPEATS
+#define SSD1306_BENCH_REPEATS  8
+#endif
+
+// SCL rates ssd1306_benchmark() tries: 100 kHz, 400 kHz, 800 kHz, 1 MHz
+#define SSD1306_BENCH_RATES  4
+
+// Bus benchmark results for one SCL rate
+typedef struct {
+    uint32_t scl_hz;
+    bool reliable;              // Every transfer was acknowledged
+    uint32_t full_us;           // Average full-frame write (window + 1024 bytes)
+    uint32_t partial_us;        // Average one-page write (window + 128 bytes)
+    uint32_t frames_per_s;      // Full frames per second, 0 if unreliable
+} ssd1306_bench_rate_t;
+
+typedef struct {
+    ssd1306_bench_rate_t rates[SSD1306_BENCH_RATES];   // Slowest first
+    uint32_t selected_hz;       // Reliable rate with the fastest frames, 0 if none
+} ssd1306_bench_result_t;
+
+// Maximum nesting of ssd1306_push_clip()
+#ifndef SSD1306_CLIP_STACK_DEPTH
+#define SSD1306_CLIP_STACK_DEPTH  8
+#endif
+
+// Gray levels for the *_gray drawing calls. Without gray mode, levels 2-3
+// draw white and 0-1 black.
+#define SSD1306_GRAY_BLACK  0
+#define SSD1306_GRAY_DARK   1
+#define SSD1306_GRAY_LIGHT  2
+#define SSD1306_GRAY_WHITE  3
+
+// Gray mode shows two bitplanes in turn, one per slot: the high plane for
+// two slots, the low plane for one, so each level is lit 0, 1/3, 2/3 or
+// all of the time
+#ifndef SSD1306_GRAY_SLOT_US
+#define SSD1306_GRAY_SLOT_US  5000
+#endif
+
+// Gray mode scheduler statistics
+typedef struct {
+    uint32_t slots;             // Plane slots since gray mode was enabled
+    uint32_t planes_sent;       // Slots whose plane reached the panel whole
+    uint32_t dropped;           // Slots skipped because the bus was still busy
+    uint32_t plane_rate_hz;     // Achieved plane flushes per second
+} ssd1306_gray_stats_t;
+
+// Display orientations for ssd1306_set_orientation(), clockwise. 90 and
+// 270 give a 64x128 portrait canvas.
+typedef enum {
+    SSD1306_ROT_0 = 0,
+    SSD1306_ROT_90,
+    SSD1306_ROT_180,
+    SSD1306_ROT_270,
+} ssd1306_orientation_t;
+
+// Continuous horizontal scroll directions
+typedef enum {
+    SSD1306_SCROLL_RIGHT = 0,
+    SSD1306_SCROLL_LEFT,
+} ssd1306_scroll_dir_t;
+
+// Async flush statistics
+typedef struct {
+    uint32_t presents;          // Frames handed to the flush task
+    uint32_t waits;             // Presents that blocked on the previous flush
+    uint64_t wait_us_total;     // Total time spent blocked
+    uint32_t wait_us_max;       // Longest single wait
+    uint32_t skipped;           // Presents with nothing drawn since the last
+} ssd1306_async_stats_t;
+
+// I2C errors and recoveries, for the whole bus
+typedef struct {
+    uint32_t timeouts;          // Transactions that timed out
+    uint32_t nacks;             // Transactions refused or failed otherwise
+    uint32_t bus_resets;        // Recoveries by clock pulses
+    uint32_t controller_resets; // Recoveries by recreating the I2C controller
+    uint32_t deadline_aborts;   // Flushes cut short by SSD1306_FLUSH_DEADLINE_US
+} ssd1306_bus_stats_t;
+
+// Transfer counts of one panel. Flushes are frames sent by an update or
+// present; gray mode plane slots count towards the bytes and
+// transactions only. Times are bus time: esp_timer microseconds, or the
+// modeled wire time on the host bus.
+typedef struct {
+    uint64_t bytes;             // Bytes put on the bus, address bytes included
+    uint32_t transactions;
+    uint32_t bus_errors;        // Failed transactions
+    uint32_t flushes;
+    uint32_t skipped_flushes;   // Flushes that found nothing to send
+    uint64_t flush_us_total;
+    uint32_t flush_us_max;
+} ssd1306_stats_t;
+
+// One flush, as recorded for ssd1306_get_frame_samples()
+typedef struct {
+    uint32_t flush_us;
+    uint16_t bytes;
+    uint16_t transactions;
+    uint8_t pages;              // Pages written
+    uint8_t bus_errors;         // Failed transactions (saturates)
+} ssd1306_frame_sample_t;
+
 /**
  * Initialize the SSD1306 display
  * @param sda_pin GPIO pin for I2C SDA
@@ -33,36 +237,409 @@ void ssd1306_clear(void);
 void ssd1306_fill(void);
 
 /**
- * Set a single pixel
+ * Set a single pixel (ignored outside the clip rectangle)
  * @param x X coordinate (0-127)
  * @param y Y coordinate (0-63)
  * @param on true = pixel on, false = pixel off
  */
 void ssd1306_set_pixel(int x, int y, bool on);
 
+/**
+ * Restrict drawing to a rectangle
+ * The new clip is the intersection of (x, y, w, h) with the current one.
+ * Pixel, rect, line, circle, ellipse and blit calls leave everything
+ * outside it untouched; clear, fill and get_pixel ignore it.
+ * @return false if the stack is full (clip unchanged, do not pop)
+ */
+bool ssd1306_push_clip(int x, int y, int w, int h);
+
+/**
+ * Restore the clip rectangle in effect before the matching push
+ */
+void ssd1306_pop_clip(void);
+
+/**
+ * Check whether a rectangle lies wholly inside the current clip
+ * Shapes that pass can draw with the unchecked pixel functions below.
+ */
+bool ssd1306_clip_contains(int x, int y, int w, int h);
+
+// Drawing state at the start of every panel handle: back frame buffer (in
+// the SSD1306_ROW_MAJOR layout), its low gray plane (NULL outside gray
+// mode), the canvas width and the dirty mask of canvas pages (16 in
+// portrait). Exposed only for the inline unchecked accessors; use the
+// functions for everything else.
+typedef struct {
+    uint8_t *buffer;
+    uint8_t *gray_plane;
+    int width;
+    uint16_t dirty_pages;
+} ssd1306_canvas_t;
+
+// Panel handle (see ssd1306_dev_init())
+typedef struct ssd1306 ssd1306_t;
+
+// The panel the single-panel calls act on, set up by ssd1306_init()
+extern ssd1306_t *const ssd1306_default;
+
+// Byte and bit of a pixel in the frame buffer
+static inline int ssd1306_pixel_index(const ssd1306_canvas_t *canvas, int x, int y) {
+#if SSD1306_ROW_MAJOR
+    (void)canvas;
+    return y * SSD1306_ROW_BYTES + (x >> 3);
+#else
+    return (y >> 3) * canvas->width + x;
+#endif
+}
+
+static inline uint8_t ssd1306_pixel_bit(int x, int y) {
+#if SSD1306_ROW_MAJOR
+    return 1 << (x & 7);
+#else
+    return 1 << (y & 7);
+#endif
+}
+
+/**
+ * Set a single pixel with no bounds or clip check
+ * For inner loops whose shape has already been clipped. Writes the frame
+ * buffer only, not the gray plane; in gray mode use ssd1306_set_pixel().
+ */
+static inline void ssd1306_dev_set_pixel_unchecked(ssd1306_t *dev, int x, int y, bool on) {
+    ssd1306_canvas_t *canvas = (ssd1306_canvas_t *)dev;
+    uint8_t *b = &canvas->buffer[ssd1306_pixel_index(canvas, x, y)];
+    uint8_t bit = ssd1306_pixel_bit(x, y);
+    *b = on ? (*b | bit) : (*b & ~bit);
+    canvas->dirty_pages |= 1 << (y >> 3);
+}
+
+static inline void ssd1306_set_pixel_unchecked(int x, int y, bool on) {
+    ssd1306_dev_set_pixel_unchecked(ssd1306_default, x, y, on);
+}
+
+/**
+ * Invert a single pixel with no bounds or clip check
+ * Frame buffer only, as above.
+ */
+static inline void ssd1306_dev_xor_pixel_unchecked(ssd1306_t *dev, int x, int y) {
+    ssd1306_canvas_t *canvas = (ssd1306_canvas_t *)dev;
+    canvas->buffer[ssd1306_pixel_index(canvas, x, y)] ^= ssd1306_pixel_bit(x, y);
+    canvas->dirty_pages |= 1 << (y >> 3);
+}
+
+static inline void ssd1306_xor_pixel_unchecked(int x, int y) {
+    ssd1306_dev_xor_pixel_unchecked(ssd1306_default, x, y);
+}
+
+/**
+ * Set a single pixel to a gray level (ignored outside the clip rectangle)
+ * @param level SSD1306_GRAY_BLACK .. SSD1306_GRAY_WHITE
+ */
+void ssd1306_set_pixel_gray(int x, int y, uint8_t level);
+
 /**
  * Get pixel state from buffer
- * @param x X coordinate (0-127)
- * @param y Y coordinate (0-63)
+ * @param x X coordinate (0 to width - 1)
+ * @param y Y coordinate (0 to height - 1)
  * @return true if pixel is on
  */
 bool ssd1306_get_pixel(int x, int y);
 
+/**
+ * Get the frame currently being drawn (8 pages of 128 bytes, the panel's
+ * layout even in SSD1306_ROW_MAJOR builds, where this converts the pages
+ * drawn since the last call)
+ * Changes after ssd1306_present_async(); fetch it again each frame.
+ */
+const uint8_t* ssd1306_get_buffer(void);
+
 /**
  * Draw a filled rectangle
+ * Clipped to the screen once, then written a byte (8 rows) at a time.
  */
 void ssd1306_fill_rect(int x, int y, int w, int h, bool on);
 
 /**
- * Draw a filled circle
+ * Draw a filled rectangle in a gray level
+ */
+void ssd1306_fill_rect_gray(int x, int y, int w, int h, uint8_t level);
+
+/**
+ * Draw a horizontal line of w pixels starting at (x, y)
+ */
+void ssd1306_hline(int x, int y, int w, bool on);
+
+/**
+ * Draw a horizontal line of w pixels in a gray level
+ */
+void ssd1306_hline_gray(int x, int y, int w, uint8_t level);
+
+/**
+ * Draw a vertical line of h pixels starting at (x, y)
+ */
+void ssd1306_vline(int x, int y, int h, bool on);
+
+/**
+ * Row pattern hook for patterned span fills
+ * @param y Screen row being filled
+ * @param user Caller context
+ * @return 8-pixel repeating pattern; bit (x & 7) is the value at column x
+ */
+typedef uint8_t (*ssd1306_row_pattern_fn)(int y, void *user);
+
+/**
+ * Draw a horizontal span of w pixels with a repeating 8-pixel pattern
+ * @param pattern Bit (x & 7) is the value at column x
+ */
+void ssd1306_hline_pattern(int x, int y, int w, uint8_t pattern);
+
+/**
+ * Draw a filled circle (radius up to 255)
+ * Covers every pixel with x*x + y*y <= r*r, one span per row.
  */
 void ssd1306_fill_circle(int cx, int cy, int r, bool on);
 
 /**
- * Send the frame buffer to the display
- * Call this after drawing operations to update the screen
+ * Draw a 1-pixel circle outline (radius up to 255)
+ */
+void ssd1306_draw_circle(int cx, int cy, int r, bool on);
+
+/**
+ * Draw a filled axis-aligned ellipse (radii up to 255)
+ * Covers every pixel with (x/rx)^2 + (y/ry)^2 <= 1, one span per row.
+ */
+void ssd1306_fill_ellipse(int cx, int cy, int rx, int ry, bool on);
+
+/**
+ * Draw a filled ellipse in a gray level
+ */
+void ssd1306_fill_ellipse_gray(int cx, int cy, int rx, int ry, uint8_t level);
+
+/**
+ * Fill an ellipse with a per-row pattern (e.g. a dithered gradient)
+ * @param pattern Called once per visible row for that row's pattern
+ * @param user Passed through to pattern
+ */
+void ssd1306_fill_ellipse_pattern(int cx, int cy, int rx, int ry,
+                                  ssd1306_row_pattern_fn pattern, void *user);
+
+/**
+ * Draw a 1-pixel ellipse outline (radii up to 255)
+ */
+void ssd1306_draw_ellipse(int cx, int cy, int rx, int ry, bool on);
+
+/**
+ * Copy a bitmap into the frame buffer
+ * Works a byte (8 rows) at a time at any y alignment; clipped to the screen.
+ * @param bmp Page-packed source bitmap
+ * @param x Left edge
+ * @param y Top edge
+ * @param rop How source pixels combine with the frame buffer
+ */
+void ssd1306_blit(const bitmap_t *bmp, int x, int y, ssd1306_rop_t rop);
+
+/**
+ * Convert a row-major, MSB-first 1bpp image to page-packed bitmap data
+ * @param rows Source rows, (width + 7) / 8 bytes each
+ * @param out Destination, ((height + 7) / 8) * width bytes
+ */
+void ssd1306_bitmap_pack(const uint8_t *rows, int width, int height, uint8_t *out);
+
+/**
+ * Send the frame buffer to the display (blocking)
+ * Call this after drawing operations to update the screen.
+ * In chunked mode only the changed column spans of each page are
+ * sent; in single mode a changed frame goes out whole in one
+ * transaction. Unchanged frames are skipped in both modes.
+ * Pages that fail or miss SSD1306_FLUSH_DEADLINE_US are sent by the
+ * next update.
+ * @return ESP_OK, ESP_ERR_TIMEOUT if the deadline cut the flush short,
+ *         ESP_FAIL if some pages failed
+ */
+esp_err_t ssd1306_update(void);
+
+/**
+ * Hand the frame buffer to the background flush task and return
+ * Drawing continues on the other buffer of a front/back pair, which
+ * starts as a copy of the presented frame. Blocks only if the previous
+ * frame is still being sent. Returns at once, sending nothing, if
+ * nothing was drawn since the last present.
+ */
+void ssd1306_present_async(void);
+
+/**
+ * Block until no flush is in progress
+ */
+void ssd1306_wait_idle(void);
+
+/**
+ * Get async flush statistics since boot
+ */
+void ssd1306_get_async_stats(ssd1306_async_stats_t *stats);
+
+/**
+ * Get I2C error and recovery counts since boot, for all panels on the bus
+ */
+void ssd1306_get_bus_stats(ssd1306_bus_stats_t *stats);
+
+/**
+ * Get transfer counts since boot
+ */
+void ssd1306_get_stats(ssd1306_stats_t *stats);
+
+/**
+ * Get the most recent flushes, oldest first
+ * Only available with SSD1306_STATS_HISTORY above 0.
+ * @param samples Where to copy them
+ * @param max Room in samples
+ * @return Number copied, at most SSD1306_STATS_HISTORY
+ */
+int ssd1306_get_frame_samples(ssd1306_frame_sample_t *samples, int max);
+
+/**
+ * Select how ssd1306_update() sends a frame
+ * @param mode SSD1306_FLUSH_CHUNKED or SSD1306_FLUSH_SINGLE
+ */
+void ssd1306_set_flush_mode(ssd1306_flush_mode_t mode);
+
+/**
+ * Get the current flush mode
+ */
+ssd1306_flush_mode_t ssd1306_get_flush_mode(void);
+
+/**
+ * Get page transfer counters since boot
+ * @param sent Pages written to the panel (may be NULL)
+ * @param skipped Pages skipped because they were unchanged (may be NULL)
+ */
+void ssd1306_get_page_stats(uint32_t *sent, uint32_t *skipped);
+
+/**
+ * Shift the whole picture vertically with the panel's start line
+ * Content moves down by rows (negative = up) and wraps around the screen.
+ * Takes effect with the next update or present, at the cost of one
+ * command byte instead of resending the shifted frame.
+ * @param rows Offset in rows, taken modulo 64
  */
-void ssd1306_update(void);
+void ssd1306_set_vertical_offset(int rows);
+
+/**
+ * Get the part of the canvas that a vertical offset wraps around to the
+ * opposite edge of the screen
+ * Drawn in the background colour, it makes the picture look moved rather
+ * than rolled. A band of rows in landscape, of columns in portrait, where
+ * the offset runs along the panel's own rows.
+ * @param rows Offset as passed to ssd1306_set_vertical_offset()
+ * @param x, y, w, h Canvas rectangle; w and h are 0 for no offset
+ */
+void ssd1306_get_offset_wrap(int rows, int *x, int *y, int *w, int *h);
+
+/**
+ * Turn 4-level grayscale on or off
+ * On, drawing calls write a second (low) bitplane as well, and a timer
+ * sends the planes in turn every SSD1306_GRAY_SLOT_US. Black and white
+ * calls set both planes alike; the *_gray calls set them per level.
+ * ssd1306_update() and ssd1306_present_async() only hand the planes to
+ * the scheduler. Needs cheap, regular flushes: use chunked flush mode
+ * and keep gray areas small.
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE before ssd1306_init(),
+ *         ESP_ERR_NO_MEM if the planes can't be allocated,
+ *         ESP_ERR_NOT_SUPPORTED in portrait or SSD1306_ROW_MAJOR builds
+ */
+esp_err_t ssd1306_set_gray_mode(bool enable);
+
+/**
+ * Check whether gray mode is on
+ */
+bool ssd1306_get_gray_mode(void);
+
+/**
+ * Get plane scheduler statistics since gray mode was last turned on
+ */
+void ssd1306_get_gray_stats(ssd1306_gray_stats_t *stats);
+
+/**
+ * Start the panel's continuous horizontal scroll on a band of pages
+ * Sends the frame buffer first, so the band scrolls whatever was drawn
+ * there; after that the panel moves it with no CPU or bus traffic. The
+ * panel must not take display RAM writes while it scrolls, so flushes
+ * send nothing until ssd1306_stop_scroll(): drawing anywhere on screen
+ * shows up only after that, and drawing into the band not at all.
+ * @param start_page First page of the band (0-7)
+ * @param end_page Last page of the band (start_page-7)
+ * @param dir SSD1306_SCROLL_RIGHT or SSD1306_SCROLL_LEFT
+ * @param frames_per_step Panel frames per 1-column step, rounded to the
+ *        nearest supported value (2, 3, 4, 5, 25, 64, 128 or 256)
+ * @return ESP_OK on success
+ */
+esp_err_t ssd1306_start_scroll(int start_page, int end_page,
+                               ssd1306_scroll_dir_t dir, int frames_per_step);
+
+/**
+ * Stop scrolling
+ * The band, and any pages drawn while it scrolled, are rewritten from
+ * the frame buffer on the next update or present, since scrolling leaves
+ * display RAM shifted.
+ */
+esp_err_t ssd1306_stop_scroll(void);
+
+/**
+ * Get the pages being scrolled (bit N = page N), 0 when not scrolling
+ */
+uint8_t ssd1306_get_scroll_pages(void);
+
+/**
+ * Change the I2C clock
+ * Waits for any flush in progress. The panel is only specified for
+ * 400 kHz; faster rates work on many modules but check with
+ * ssd1306_benchmark() first.
+ * @param scl_hz SCL frequency in Hz
+ * @return ESP_OK on success
+ */
+esp_err_t ssd1306_set_bus_speed(uint32_t scl_hz);
+
+/**
+ * Get the current I2C clock in Hz
+ */
+uint32_t ssd1306_get_bus_speed(void);
+
+/**
+ * Time full-frame and one-page writes at each SCL rate and pick the
+ * fastest one whose transfers all succeed
+ * Rewrites what the panel already shows, so the screen doesn't change.
+ * Blocks the bus for the duration (tens of milliseconds). Not available
+ * while scrolling. On the host bus, times come from its wire model
+ * (hostbus_set_timing()).
+ * @param result Per-rate timings and the selected rate
+ * @param apply true = switch to the selected rate, false = restore the
+ *        rate in use before
+ * @return ESP_OK if a reliable rate was found, ESP_FAIL if none was,
+ *         ESP_ERR_INVALID_STATE before ssd1306_init() or while scrolling
+ */
+esp_err_t ssd1306_benchmark(ssd1306_bench_result_t *result, bool apply);
+
+/**
+ * Rotate and/or mirror the picture
+ * 0 and 180 degrees and mirroring only reprogram the panel's segment and
+ * COM scan direction, so they cost nothing per frame and keep the frame.
+ * 90 and 270 switch drawing to a 64x128 canvas (see ssd1306_get_width()),
+ * cleared on the switch, which is transposed onto the panel 8x8 bits at
+ * a time when flushed. The vertical offset and horizontal scroll act on
+ * the canvas axes in landscape; in portrait they act along the panel's
+ * own axes (sideways and vertically on the canvas).
+ * @param rotation SSD1306_ROT_0 .. SSD1306_ROT_270
+ * @param mirror true = flip left-right (before rotating)
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED for portrait in gray
+ *         mode or SSD1306_ROW_MAJOR builds, ESP_ERR_NO_MEM if the portrait
+ *         canvas can't be allocated
+ */
+esp_err_t ssd1306_set_orientation(ssd1306_orientation_t rotation, bool mirror);
+
+/**
+ * Get the drawing canvas size (128x64, or 64x128 in portrait)
+ */
+int ssd1306_get_width(void);
+int ssd1306_get_height(void);
 
 /**
  * Set display contrast (brightness)
@@ -76,5 +653,82 @@ void ssd1306_set_contrast(uint8_t contrast);
  */
 void ssd1306_invert(bool invert);
 
+// ============================================================================
+// MULTI-PANEL API
+// ============================================================================
+//
+// Several panels (e.g. one per eye at 0x3C and 0x3D) can share the I2C bus,
+// each with its own handle. Every single-panel call above has an
+// ssd1306_dev_* counterpart that takes the handle first and behaves the
+// same on that panel; the single-panel calls act on ssd1306_default.
+//
+// One flush task serves the whole bus. Frames presented to several panels
+// are sent interleaved, a page with changes from each panel in turn, so
+// the panels finish together and neither waits out the other's whole
+// frame. Blocking calls on one panel wait only for that panel's own
+// flush, plus whatever page is on the bus at the time.
+
+/**
+ * Set up another panel on the bus
+ * The first panel set up (by this or ssd1306_init()) creates the bus;
+ * later ones join it and their pins are ignored. Panels stay set up
+ * until reboot.
+ * @param out Handle of the new panel
+ * @param i2c_addr Its I2C address
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if SSD1306_MAX_PANELS are set up
+ *         or the handle can't be allocated
+ */
+esp_err_t ssd1306_dev_init(ssd1306_t **out, int sda_pin, int scl_pin, uint8_t i2c_addr);
+
+void ssd1306_dev_clear(ssd1306_t *dev);
+void ssd1306_dev_fill(ssd1306_t *dev);
+bool ssd1306_dev_push_clip(ssd1306_t *dev, int x, int y, int w, int h);
+void ssd1306_dev_pop_clip(ssd1306_t *dev);
+bool ssd1306_dev_clip_contains(ssd1306_t *dev, int x, int y, int w, int h);
+void ssd1306_dev_set_pixel(ssd1306_t *dev, int x, int y, bool on);
+void ssd1306_dev_set_pixel_gray(ssd1306_t *dev, int x, int y, uint8_t level);
+bool ssd1306_dev_get_pixel(ssd1306_t *dev, int x, int y);
+const uint8_t* ssd1306_dev_get_buffer(ssd1306_t *dev);
+void ssd1306_dev_fill_rect(ssd1306_t *dev, int x, int y, int w, int h, bool on);
+void ssd1306_dev_fill_rect_gray(ssd1306_t *dev, int x, int y, int w, int h, uint8_t level);
+void ssd1306_dev_hline(ssd1306_t *dev, int x, int y, int w, bool on);
+void ssd1306_dev_hline_gray(ssd1306_t *dev, int x, int y, int w, uint8_t level);
+void ssd1306_dev_vline(ssd1306_t *dev, int x, int y, int h, bool on);
+void ssd1306_dev_hline_pattern(ssd1306_t *dev, int x, int y, int w, uint8_t pattern);
+void ssd1306_dev_fill_circle(ssd1306_t *dev, int cx, int cy, int r, bool on);
+void ssd1306_dev_draw_circle(ssd1306_t *dev, int cx, int cy, int r, bool on);
+void ssd1306_dev_fill_ellipse(ssd1306_t *dev, int cx, int cy, int rx, int ry, bool on);
+void ssd1306_dev_fill_ellipse_gray(ssd1306_t *dev, int cx, int cy, int rx, int ry, uint8_t level);
+void ssd1306_dev_fill_ellipse_pattern(ssd1306_t *dev, int cx, int cy, int rx, int ry,
+                                      ssd1306_row_pattern_fn pattern, void *user);
+void ssd1306_dev_draw_ellipse(ssd1306_t *dev, int cx, int cy, int rx, int ry, bool on);
+void ssd1306_dev_blit(ssd1306_t *dev, const bitmap_t *bmp, int x, int y, ssd1306_rop_t rop);
+esp_err_t ssd1306_dev_update(ssd1306_t *dev);
+void ssd1306_dev_present_async(ssd1306_t *dev);
+void ssd1306_dev_wait_idle(ssd1306_t *dev);
+void ssd1306_dev_get_async_stats(ssd1306_t *dev, ssd1306_async_stats_t *stats);
+void ssd1306_dev_get_stats(ssd1306_t *dev, ssd1306_stats_t *stats);
+int ssd1306_dev_get_frame_samples(ssd1306_t *dev, ssd1306_frame_sample_t *samples, int max);
+void ssd1306_dev_set_flush_mode(ssd1306_t *dev, ssd1306_flush_mode_t mode);
+ssd1306_flush_mode_t ssd1306_dev_get_flush_mode(ssd1306_t *dev);
+void ssd1306_dev_get_page_stats(ssd1306_t *dev, uint32_t *sent, uint32_t *skipped);
+void ssd1306_dev_set_vertical_offset(ssd1306_t *dev, int rows);
+void ssd1306_dev_get_offset_wrap(ssd1306_t *dev, int rows, int *x, int *y, int *w, int *h);
+esp_err_t ssd1306_dev_set_gray_mode(ssd1306_t *dev, bool enable);
+bool ssd1306_dev_get_gray_mode(ssd1306_t *dev);
+void ssd1306_dev_get_gray_stats(ssd1306_t *dev, ssd1306_gray_stats_t *stats);
+esp_err_t ssd1306_dev_start_scroll(ssd1306_t *dev, int start_page, int end_page,
+                                   ssd1306_scroll_dir_t dir, int frames_per_step);
+esp_err_t ssd1306_dev_stop_scroll(ssd1306_t *dev);
+uint8_t ssd1306_dev_get_scroll_pages(ssd1306_t *dev);
+esp_err_t ssd1306_dev_set_bus_speed(ssd1306_t *dev, uint32_t scl_hz);
+uint32_t ssd1306_dev_get_bus_speed(ssd1306_t *dev);
+esp_err_t ssd1306_dev_benchmark(ssd1306_t *dev, ssd1306_bench_result_t *result, bool apply);
+esp_err_t ssd1306_dev_set_orientation(ssd1306_t *dev, ssd1306_orientation_t rotation, bool mirror);
+int ssd1306_dev_get_width(ssd1306_t *dev);
+int ssd1306_dev_get_height(ssd1306_t *dev);
+void ssd1306_dev_set_contrast(ssd1306_t *dev, uint8_t contrast);
+void ssd1306_dev_invert(ssd1306_t *dev, bool invert);
+
 #endif // SSD1306_H
 
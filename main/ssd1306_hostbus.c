@@ -0,0 +1,387 @@
+/*
+ * Host-side stand-in for the SSD1306 I2C bus
+ * Emulates horizontal addressing mode display RAM writes of each panel on
+ * the bus and the time they take on the wire
+ */
+
+#include "ssd1306_hostbus.h"
+#include "ssd1306.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define PAGES   (SSD1306_HEIGHT / 8)
+
+static hostbus_stats_t stats;
+
+// Wire timing: the model and the bus time used so far
+static hostbus_timing_t timing;
+static uint64_t bus_time_ns = 0;
+
+// Frame intervals by 3-bit scroll speed code
+static const uint16_t scroll_intervals[8] = {5, 64, 128, 256, 3, 4, 25, 2};
+
+// One emulated panel, and the clock the driver talks to it at
+typedef struct {
+    bool attached;
+    uint8_t i2c_addr;
+    uint32_t scl_hz;
+    uint8_t ram[SSD1306_WIDTH * PAGES];
+
+    // Address window and write cursor
+    struct {
+        uint8_t col_start, col_end;
+        uint8_t page_start, page_end;
+        uint8_t col, page;
+    } addr;
+
+    // Display start line (0x40-0x7F)
+    uint8_t start_line;
+
+    // Segment remap (0xA0/0xA1) and COM scan direction (0xC0/0xC8)
+    bool seg_remap;
+    bool com_remap;
+
+    // Continuous horizontal scroll (0x26/0x27 setup, 0x2F on, 0x2E off)
+    struct {
+        bool left;
+        uint8_t start_page, end_page;
+        uint16_t interval;      // Frames per 1-column step
+        bool active;
+        uint32_t frames;        // Frames since the last step
+    } scroll;
+
+    // Command currently collecting its argument bytes
+    struct {
+        uint8_t opcode;
+        uint8_t args[8];
+        uint8_t count;
+        uint8_t needed;
+    } pending;
+} panel_t;
+
+static panel_t panels[HOSTBUS_MAX_PANELS];
+static panel_t *selected = NULL;    // Panel the inspection calls look at
+
+// Injected faults and their random state
+static hostbus_faults_t faults;
+static uint32_t fault_rng = 1;
+static bool sda_stuck = false;
+
+// Called after each accepted transaction
+static hostbus_write_hook_t write_hook = NULL;
+static void *write_hook_arg = NULL;
+
+// Number of argument bytes following a command opcode
+static uint8_t cmd_arg_count(uint8_t opcode) {
+    switch (opcode) {
+        case 0x26: case 0x27:                   // Horizontal scroll setup
+            return 6;
+        case 0x29: case 0x2A:                   // Vertical + horizontal scroll
+            return 5;
+        case 0x21: case 0x22: case 0xA3:        // Column / page address, scroll area
+            return 2;
+        case 0x20: case 0x81: case 0x8D:        // Memory mode, contrast, pump
+        case 0xA8: case 0xD3: case 0xD5:        // Mux, offset, clock
+        case 0xD9: case 0xDA: case 0xDB:        // Precharge, COM pins, VCOMH
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void execute_cmd(panel_t *p, uint8_t opcode, const uint8_t *args) {
+    switch (opcode) {
+        case 0x21:
+            p->addr.col_start = args[0] & 0x7F;
+            p->addr.col_end = args[1] & 0x7F;
+            p->addr.col = p->addr.col_start;
+            break;
+        case 0x22:
+            p->addr.page_start = args[0] & 0x07;
+            p->addr.page_end = args[1] & 0x07;
+            p->addr.page = p->addr.page_start;
+            break;
+        case 0x26:
+        case 0x27:
+            p->scroll.left = (opcode == 0x27);
+            p->scroll.start_page = args[1] & 0x07;
+            p->scroll.interval = scroll_intervals[args[2] & 0x07];
+            p->scroll.end_page = args[3] & 0x07;
+            break;
+        case 0x2E:
+            p->scroll.active = false;
+            break;
+        case 0x2F:
+            p->scroll.active = true;
+            p->scroll.frames = 0;
+            break;
+        case 0xA0:
+        case 0xA1:
+            p->seg_remap = (opcode & 1);
+            break;
+        case 0xC0:
+        case 0xC8:
+            p->com_remap = (opcode & 0x08);
+            break;
+        default:
+            if ((opcode & 0xC0) == 0x40) p->start_line = opcode & 0x3F;
+            break;
+    }
+}
+
+static void feed_cmd(panel_t *p, uint8_t byte) {
+    stats.cmd_bytes++;
+
+    if (p->pending.needed) {
+        p->pending.args[p->pending.count++] = byte;
+        if (p->pending.count == p->pending.needed) {
+            p->pending.needed = 0;
+            execute_cmd(p, p->pending.opcode, p->pending.args);
+        }
+        return;
+    }
+
+    uint8_t needed = cmd_arg_count(byte);
+    if (needed) {
+        p->pending.opcode = byte;
+        p->pending.count = 0;
+        p->pending.needed = needed;
+    } else {
+        execute_cmd(p, byte, NULL);
+    }
+}
+
+static void feed_data(panel_t *p, uint8_t byte) {
+    stats.data_bytes++;
+    // The datasheet forbids RAM writes of any page during a scroll
+    if (p->scroll.active) stats.scroll_writes++;
+    p->ram[p->addr.page * SSD1306_WIDTH + p->addr.col] = byte;
+
+    // Horizontal addressing: wrap column, then page, inside the window
+    if (p->addr.col >= p->addr.col_end) {
+        p->addr.col = p->addr.col_start;
+        p->addr.page = (p->addr.page >= p->addr.page_end) ? p->addr.page_start : p->addr.page + 1;
+    } else {
+        p->addr.col++;
+    }
+}
+
+static panel_t *find_panel(uint8_t i2c_addr) {
+    for (int i = 0; i < HOSTBUS_MAX_PANELS; i++) {
+        if (panels[i].attached && panels[i].i2c_addr == i2c_addr) return &panels[i];
+    }
+    return NULL;
+}
+
+void hostbus_reset(void) {
+    memset(panels, 0, sizeof(panels));
+    selected = NULL;
+    sda_stuck = false;
+    bus_time_ns = 0;
+    hostbus_reset_stats();
+}
+
+esp_err_t hostbus_attach(uint8_t i2c_addr) {
+    panel_t *p = find_panel(i2c_addr);
+    for (int i = 0; !p && i < HOSTBUS_MAX_PANELS; i++) {
+        if (!panels[i].attached) p = &panels[i];
+    }
+    if (!p) return ESP_ERR_NO_MEM;
+
+    memset(p, 0, sizeof(*p));
+    p->attached = true;
+    p->i2c_addr = i2c_addr;
+    p->scl_hz = 400000;
+    p->addr.col_end = SSD1306_WIDTH - 1;
+    p->addr.page_end = PAGES - 1;
+    if (!selected) selected = p;
+    return ESP_OK;
+}
+
+void hostbus_select(uint8_t i2c_addr) {
+    panel_t *p = find_panel(i2c_addr);
+    if (p) selected = p;
+}
+
+// Add the wire time of a transaction of the given length (address byte
+// included) to the bus clock
+static void charge_time(uint32_t scl_hz, size_t bytes) {
+    uint64_t byte_ns = 9ULL * 1000000000ULL / scl_hz + timing.byte_gap_ns;
+    bus_time_ns += (uint64_t)timing.txn_overhead_us * 1000 + bytes * byte_ns;
+}
+
+// Fault draw: true with the given chance per thousand
+static bool fault_hit(uint16_t per_mille) {
+    if (!per_mille) return false;
+    fault_rng ^= fault_rng << 13;
+    fault_rng ^= fault_rng >> 17;
+    fault_rng ^= fault_rng << 5;
+    return fault_rng % 1000 < per_mille;
+}
+
+static void feed(panel_t *p, const uint8_t *buf, size_t len) {
+    uint8_t control = buf[0];
+    if (control == 0x40) {
+        for (size_t i = 1; i < len; i++) feed_data(p, buf[i]);
+    } else if (control == 0x00) {
+        for (size_t i = 1; i < len; i++) feed_cmd(p, buf[i]);
+    } else if (control == 0x80) {
+        // Co=1: control/command byte pairs
+        for (size_t i = 1; i < len; i++) {
+            feed_cmd(p, buf[i]);
+            if (i + 1 < len) i++;  // Skip the next control byte
+        }
+    }
+}
+
+// Fail a transaction partway: a random prefix reaches the panel first
+static esp_err_t inject_fault(panel_t *p, const uint8_t *buf, size_t len, esp_err_t err,
+                              uint32_t timeout_ms) {
+    size_t delivered = fault_rng % len;
+    stats.bytes += 1 + delivered;
+    if (delivered) feed(p, buf, delivered);
+    p->pending.needed = 0;
+
+    if (err == ESP_ERR_TIMEOUT) {
+        stats.timeouts++;
+        bus_time_ns += (uint64_t)timeout_ms * 1000000;
+    } else {
+        stats.nacks++;
+        charge_time(p->scl_hz, 1 + delivered);
+    }
+    return err;
+}
+
+esp_err_t hostbus_transmit(uint8_t i2c_addr, const uint8_t *buf, size_t len, uint32_t timeout_ms) {
+    if (!buf || len == 0) return ESP_ERR_INVALID_ARG;
+    if (buf[0] != 0x00 && buf[0] != 0x40 && buf[0] != 0x80) return ESP_ERR_INVALID_ARG;
+
+    stats.transactions++;
+
+    // Nothing gets through while SDA is held low
+    if (sda_stuck) {
+        stats.timeouts++;
+        bus_time_ns += (uint64_t)timeout_ms * 1000000;
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // Nobody at that address, or too fast for the panel: the address byte
+    // goes unacknowledged
+    panel_t *p = find_panel(i2c_addr);
+    if (!p || (timing.max_scl_hz && p->scl_hz > timing.max_scl_hz)) {
+        stats.bytes++;
+        stats.nacks++;
+        charge_time(p ? p->scl_hz : 400000, 1);
+        return ESP_FAIL;
+    }
+
+    if (fault_hit(faults.stuck_per_mille)) {
+        sda_stuck = true;
+        return inject_fault(p, buf, len, ESP_ERR_TIMEOUT, timeout_ms);
+    }
+    if (fault_hit(faults.timeout_per_mille)) return inject_fault(p, buf, len, ESP_ERR_TIMEOUT, timeout_ms);
+    if (fault_hit(faults.nack_per_mille)) return inject_fault(p, buf, len, ESP_FAIL, timeout_ms);
+
+    stats.bytes += 1 + len;  // Address byte + payload
+    charge_time(p->scl_hz, 1 + len);
+    feed(p, buf, len);
+    if (write_hook) write_hook(i2c_addr, write_hook_arg);
+    return ESP_OK;
+}
+
+void hostbus_set_faults(const hostbus_faults_t *f) {
+    if (f) {
+        faults = *f;
+    } else {
+        memset(&faults, 0, sizeof(faults));
+    }
+    fault_rng = faults.seed ? faults.seed : 1;
+}
+
+void hostbus_bus_reset(void) {
+    stats.bus_resets++;
+    sda_stuck = false;
+    // Nine SCL pulses and a stop condition
+    charge_time(100000, 2);
+}
+
+void hostbus_set_timing(const hostbus_timing_t *t) {
+    if (t) timing = *t;
+}
+
+void hostbus_set_write_hook(hostbus_write_hook_t hook, void *arg) {
+    write_hook = hook;
+    write_hook_arg = arg;
+}
+
+void hostbus_set_scl_hz(uint8_t i2c_addr, uint32_t hz) {
+    panel_t *p = find_panel(i2c_addr);
+    if (p && hz) p->scl_hz = hz;
+}
+
+uint64_t hostbus_get_time_us(void) {
+    return bus_time_ns / 1000;
+}
+
+void hostbus_get_stats(hostbus_stats_t *out) {
+    if (out) *out = stats;
+}
+
+void hostbus_reset_stats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+const uint8_t* hostbus_get_ram(void) {
+    static const uint8_t blank[SSD1306_WIDTH * PAGES];
+    return selected ? selected->ram : blank;
+}
+
+uint8_t hostbus_get_start_line(void) {
+    return selected ? selected->start_line : 0;
+}
+
+bool hostbus_get_screen_pixel(int x, int y) {
+    if (!selected || x < 0 || x >= SSD1306_WIDTH || y < 0 || y >= SSD1306_HEIGHT) return false;
+    int col = selected->seg_remap ? x : SSD1306_WIDTH - 1 - x;
+    int row = selected->com_remap ? y : SSD1306_HEIGHT - 1 - y;
+    row = (row + selected->start_line) & (SSD1306_HEIGHT - 1);
+    return (selected->ram[(row >> 3) * SSD1306_WIDTH + col] >> (row & 7)) & 1;
+}
+
+// Move one panel's scroll band by however many steps fit in the frames
+static void advance_panel(panel_t *p, uint32_t frames) {
+    if (!p->scroll.active || p->scroll.start_page > p->scroll.end_page) return;
+
+    p->scroll.frames += frames;
+    while (p->scroll.frames >= p->scroll.interval) {
+        p->scroll.frames -= p->scroll.interval;
+
+        // Rotate each page of the band by one column
+        for (int page = p->scroll.start_page; page <= p->scroll.end_page; page++) {
+            uint8_t *row = &p->ram[page * SSD1306_WIDTH];
+            if (p->scroll.left) {
+                uint8_t first = row[0];
+                memmove(row, row + 1, SSD1306_WIDTH - 1);
+                row[SSD1306_WIDTH - 1] = first;
+            } else {
+                uint8_t last = row[SSD1306_WIDTH - 1];
+                memmove(row + 1, row, SSD1306_WIDTH - 1);
+                row[0] = last;
+            }
+        }
+    }
+}
+
+void hostbus_advance_frames(uint32_t frames) {
+    for (int i = 0; i < HOSTBUS_MAX_PANELS; i++) {
+        if (panels[i].attached) advance_panel(&panels[i], frames);
+    }
+}
+
+uint8_t hostbus_get_scroll_pages(void) {
+    if (!selected || !selected->scroll.active ||
+        selected->scroll.start_page > selected->scroll.end_page) {
+        return 0;
+    }
+    return (uint8_t)((0xFF << selected->scroll.start_page) & (0xFF >> (7 - selected->scroll.end_page)));
+}
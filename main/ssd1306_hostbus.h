@@ -0,0 +1,160 @@
+/*
+ * Host-side stand-in for the SSD1306 I2C bus
+ * Decodes the byte stream the driver sends, keeps an emulated copy of each
+ * attached panel's display RAM, counts traffic and models how long it would take on
+ * the wire, so flush logic and bus tuning can be measured and checked
+ * without a panel attached.
+ */
+
+#ifndef SSD1306_HOSTBUS_H
+#define SSD1306_HOSTBUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Panels that can share the emulated bus
+#define HOSTBUS_MAX_PANELS  4
+
+// Bus traffic counters
+typedef struct {
+    uint32_t transactions;  // Write transactions (start ... stop)
+    uint32_t bytes;         // Bytes on the wire, including the address byte
+    uint32_t data_bytes;    // Bytes written to display RAM
+    uint32_t cmd_bytes;     // Command and command-argument bytes
+    uint32_t scroll_writes; // Data bytes written while a scroll runs
+    uint32_t nacks;         // Transactions refused (no panel, clock too fast, injected)
+    uint32_t timeouts;      // Transactions that timed out (injected, or SDA stuck)
+    uint32_t bus_resets;    // hostbus_bus_reset() calls
+} hostbus_stats_t;
+
+// Wire timing model. A transaction takes txn_overhead_us plus, per byte,
+// 9 SCL periods and byte_gap_ns.
+typedef struct {
+    uint32_t txn_overhead_us;   // Start/stop, driver and interrupt latency
+    uint32_t byte_gap_ns;       // Idle time between bytes (FIFO refills etc.)
+    uint32_t max_scl_hz;        // Fastest clock the panel keeps up with, 0 = no limit
+} hostbus_timing_t;
+
+// Injected faults, to exercise error handling. Each transaction fails with
+// the given chances, after a random part of it has reached the panel (a
+// command cut short is dropped). A stuck transaction also leaves SDA held
+// low, so every one after it times out until hostbus_bus_reset().
+typedef struct {
+    uint16_t nack_per_mille;
+    uint16_t timeout_per_mille;
+    uint16_t stuck_per_mille;
+    uint32_t seed;              // Same seed, same faults
+} hostbus_faults_t;
+
+/**
+ * Detach every panel and reset the counters and bus clock. Timing
+ * settings are kept.
+ */
+void hostbus_reset(void);
+
+/**
+ * Put a panel on the bus, or reset the one already at that address, in
+ * its power-on state (RAM cleared, full address window, 400 kHz)
+ * The first panel attached after a reset is the one the inspection calls
+ * below look at.
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if HOSTBUS_MAX_PANELS are attached
+ */
+esp_err_t hostbus_attach(uint8_t i2c_addr);
+
+/**
+ * Choose the panel hostbus_get_ram(), hostbus_get_start_line(),
+ * hostbus_get_screen_pixel() and hostbus_get_scroll_pages() look at
+ */
+void hostbus_select(uint8_t i2c_addr);
+
+/**
+ * Handle one write transaction, as i2c_master_transmit() would
+ * @param i2c_addr Panel address
+ * @param buf Control byte (0x00 = commands, 0x40 = data) followed by payload
+ * @param len Number of bytes in buf
+ * @param timeout_ms Bus time a timed-out transaction costs
+ * @return ESP_OK on success, ESP_FAIL if no panel acknowledges (none at
+ *         that address, SCL above hostbus_timing_t.max_scl_hz, or an
+ *         injected NACK), ESP_ERR_TIMEOUT for an injected timeout or a
+ *         stuck bus
+ */
+esp_err_t hostbus_transmit(uint8_t i2c_addr, const uint8_t *buf, size_t len, uint32_t timeout_ms);
+
+/**
+ * Set the injected faults (NULL = none, the default)
+ */
+void hostbus_set_faults(const hostbus_faults_t *faults);
+
+/**
+ * Clock the bus free, as i2c_master_bus_reset() would: releases a stuck SDA
+ */
+void hostbus_bus_reset(void);
+
+/**
+ * Set the wire timing model (all zero by default: free, never fails)
+ */
+void hostbus_set_timing(const hostbus_timing_t *timing);
+
+/**
+ * Watch the panels change: hook runs after every transaction a panel
+ * accepts, on the thread that sent it, so it can look at the emulated
+ * state between transactions (NULL = none, the default)
+ */
+typedef void (*hostbus_write_hook_t)(uint8_t i2c_addr, void *arg);
+void hostbus_set_write_hook(hostbus_write_hook_t hook, void *arg);
+
+/**
+ * Set the SCL frequency transactions to one panel are timed at
+ */
+void hostbus_set_scl_hz(uint8_t i2c_addr, uint32_t scl_hz);
+
+/**
+ * Get the modeled bus time spent since the last reset, all panels together, in microseconds
+ */
+uint64_t hostbus_get_time_us(void);
+
+/**
+ * Get traffic counters since the last reset
+ */
+void hostbus_get_stats(hostbus_stats_t *stats);
+
+/**
+ * Clear traffic counters without touching the emulated panel
+ */
+void hostbus_reset_stats(void);
+
+/**
+ * Get the emulated display RAM (8 pages of 128 bytes, same layout as the
+ * driver's frame buffer)
+ */
+const uint8_t* hostbus_get_ram(void);
+
+/**
+ * Get the emulated display start line: screen row r shows RAM row
+ * (r + start line) mod 64
+ */
+uint8_t hostbus_get_start_line(void);
+
+/**
+ * Get a pixel as it appears on screen: through the start line and the
+ * segment remap / COM scan direction, with the driver's init settings
+ * (both remapped) as upright
+ * @param x Screen column (0-127)
+ * @param y Screen row (0-63)
+ */
+bool hostbus_get_screen_pixel(int x, int y);
+
+/**
+ * Let the emulated panels run for a number of display frames
+ * Moves each active horizontal scroll band one column per step interval.
+ */
+void hostbus_advance_frames(uint32_t frames);
+
+/**
+ * Get the pages being scrolled (bit N = page N), 0 when not scrolling
+ */
+uint8_t hostbus_get_scroll_pages(void);
+
+#endif // SSD1306_HOSTBUS_H
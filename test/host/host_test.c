@@ -0,0 +1,51 @@
+/*
+ * Host test helpers
+ */
+
+#include "host_test.h"
+#include "ssd1306.h"
+#include "ssd1306_hostbus.h"
+#include "esp_log.h"
+#include <string.h>
+
+// Updates host_test_flush() allows for one frame: enough for a full
+// frame spread over several flushes by the deadline
+#define FLUSH_TRIES  16
+
+void host_test_init(void) {
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    CHECK(ssd1306_init(-1, -1, HOST_TEST_ADDR) == ESP_OK);
+}
+
+void host_test_reset(void) {
+    ssd1306_wait_idle();
+    hostbus_set_faults(NULL);
+    hostbus_set_timing(&(hostbus_timing_t){0});
+    CHECK(ssd1306_set_bus_speed(SSD1306_I2C_SPEED_HZ) == ESP_OK);
+    ssd1306_set_flush_mode(SSD1306_FLUSH_CHUNKED);
+    ssd1306_clear();
+    CHECK(host_test_flush());
+    hostbus_reset_stats();
+}
+
+void host_test_draw_frame(int n) {
+    ssd1306_clear();
+    ssd1306_fill_circle(16 + (n * 5) % 96, 32, 12, true);
+    ssd1306_fill_rect((n * 7) % 120, (n * 3) % 56, 8, 8, true);
+    ssd1306_draw_ellipse(64, 32, 20 + n % 24, 10 + n % 12, true);
+    ssd1306_hline(0, n % 64, 128, true);
+    ssd1306_vline(127 - n % 128, 0, 64, true);
+}
+
+bool host_test_flush(void) {
+    for (int i = 0; i < FLUSH_TRIES; i++) {
+        if (ssd1306_update() == ESP_OK) return true;
+    }
+    return false;
+}
+
+bool host_test_panel_matches(void) {
+    ssd1306_wait_idle();
+    return hostbus_get_start_line() == 0 &&
+           memcmp(hostbus_get_ram(), ssd1306_get_buffer(), SSD1306_WIDTH * SSD1306_HEIGHT / 8) == 0;
+}
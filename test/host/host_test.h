@@ -0,0 +1,66 @@
+/*
+ * Host test helpers
+ * The tests run the SSD1306 driver against the in-memory bus
+ * (ssd1306_hostbus.h) and check what reaches the emulated panel.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Panel address the tests drive
+#define HOST_TEST_ADDR  0x3C
+
+// Fail the test (exit status 1) if cond is false
+#define CHECK(cond) do {                                                            \
+        if (!(cond)) {                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                                \
+        }                                                                           \
+    } while (0)
+
+// Same, for two unsigned values that must be equal
+#define CHECK_EQ(a, b) do {                                                         \
+        unsigned long long a_ = (unsigned long long)(a);                            \
+        unsigned long long b_ = (unsigned long long)(b);                            \
+        if (a_ != b_) {                                                             \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%llu != %llu)\n",       \
+                    __FILE__, __LINE__, #a, #b, a_, b_);                            \
+            exit(1);                                                                \
+        }                                                                           \
+    } while (0)
+
+/**
+ * Set up the default panel on the host bus, with logging down to errors
+ */
+void host_test_init(void);
+
+/**
+ * Put the bus back to its defaults (no faults, free timing, 400 kHz,
+ * chunked flushes), blank the panel and clear the bus counters
+ */
+void host_test_reset(void);
+
+/**
+ * Draw test frame n into the frame buffer: shapes that move from frame to
+ * frame, so each one changes a few spans on most pages
+ */
+void host_test_draw_frame(int n);
+
+/**
+ * Update until a flush goes through whole, as after a deadline cut or
+ * failed pages
+ * @return Whether one did within a few tries
+ */
+bool host_test_flush(void);
+
+/**
+ * Whether the emulated panel RAM holds exactly the frame buffer
+ * Waits for any flush in progress first.
+ */
+bool host_test_panel_matches(void);
+
+#endif // HOST_TEST_H
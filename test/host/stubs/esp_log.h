@@ -0,0 +1,35 @@
+/*
+ * ESP-IDF stand-in for host tests: logging to stderr
+ */
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+// Only the "*" tag is supported: one level for everything
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+esp_log_level_t esp_log_level_get(const char *tag);
+
+#define ESP_LOG_LEVEL_PRINT(level, letter, tag, format, ...) do {                   \
+        if (esp_log_level_get(tag) >= (level)) {                                    \
+            fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__);       \
+        }                                                                           \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...)  ESP_LOG_LEVEL_PRINT(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  ESP_LOG_LEVEL_PRINT(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  ESP_LOG_LEVEL_PRINT(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)  ESP_LOG_LEVEL_PRINT(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)  ESP_LOG_LEVEL_PRINT(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
+
+#endif // ESP_LOG_H
@@ -0,0 +1,110 @@
+/*
+ * ESP-IDF stand-in for host tests: error names, log level and esp_timer
+ */
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// ============================================================================
+// ERRORS AND LOGGING
+// ============================================================================
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        default:                    return "UNKNOWN ERROR";
+    }
+}
+
+static volatile esp_log_level_t log_level = ESP_LOG_INFO;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    (void)tag;
+    log_level = level;
+}
+
+esp_log_level_t esp_log_level_get(const char *tag) {
+    (void)tag;
+    return log_level;
+}
+
+// ============================================================================
+// TIMERS
+// ============================================================================
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    uint64_t period_us;
+    bool running;                   // Atomic: the timer thread polls it
+    pthread_t thread;
+};
+
+int64_t esp_timer_get_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out) {
+    if (!args || !args->callback || !out) return ESP_ERR_INVALID_ARG;
+    esp_timer_handle_t timer = calloc(1, sizeof(*timer));
+    if (!timer) return ESP_ERR_NO_MEM;
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+    *out = timer;
+    return ESP_OK;
+}
+
+static void *timer_thread(void *p) {
+    esp_timer_handle_t timer = p;
+    int64_t next = esp_timer_get_time() + (int64_t)timer->period_us;
+    while (__atomic_load_n(&timer->running, __ATOMIC_ACQUIRE)) {
+        int64_t wait = next - esp_timer_get_time();
+        if (wait > 0) usleep((useconds_t)wait);
+        if (!__atomic_load_n(&timer->running, __ATOMIC_ACQUIRE)) break;
+        timer->callback(timer->arg);
+        next += (int64_t)timer->period_us;
+    }
+    return NULL;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+    if (!timer || !period_us) return ESP_ERR_INVALID_ARG;
+    if (timer->running) return ESP_ERR_INVALID_STATE;
+    timer->period_us = period_us;
+    timer->running = true;
+    if (pthread_create(&timer->thread, NULL, timer_thread, timer) != 0) {
+        timer->running = false;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (!timer->running) return ESP_ERR_INVALID_STATE;
+    __atomic_store_n(&timer->running, false, __ATOMIC_RELEASE);
+    pthread_join(timer->thread, NULL);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer->running) return ESP_ERR_INVALID_STATE;
+    free(timer);
+    return ESP_OK;
+}
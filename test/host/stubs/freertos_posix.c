@@ -0,0 +1,204 @@
+/*
+ * FreeRTOS stand-in for host tests, on POSIX threads
+ * Just enough of tasks, semaphores and queues for the display driver.
+ * Timeouts are real time.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// ============================================================================
+// TIME
+// ============================================================================
+
+TickType_t xTaskGetTickCount(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    usleep((useconds_t)ticks * 1000);
+}
+
+// Absolute CLOCK_REALTIME deadline some ticks from now, for timed waits
+static struct timespec deadline_in(TickType_t ticks) {
+    struct timespec t;
+    clock_gettime(CLOCK_REALTIME, &t);
+    t.tv_sec += ticks / 1000;
+    t.tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (t.tv_nsec >= 1000000000) {
+        t.tv_sec++;
+        t.tv_nsec -= 1000000000;
+    }
+    return t;
+}
+
+// Wait on a condition, forever or up to a deadline. Returns false on timeout.
+static bool wait_cond(pthread_cond_t *cond, pthread_mutex_t *mutex, TickType_t ticks,
+                      const struct timespec *deadline) {
+    if (ticks == portMAX_DELAY) return pthread_cond_wait(cond, mutex) == 0;
+    if (ticks == 0) return false;
+    return pthread_cond_timedwait(cond, mutex, deadline) == 0;
+}
+
+// ============================================================================
+// TASKS
+// ============================================================================
+
+typedef struct {
+    TaskFunction_t fn;
+    void *arg;
+} task_start_t;
+
+static void *task_thread(void *p) {
+    task_start_t start = *(task_start_t *)p;
+    free(p);
+    start.fn(start.arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *out) {
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+    
+    task_start_t *start = malloc(sizeof(*start));
+    if (!start) return pdFAIL;
+    start->fn = fn;
+    start->arg = arg;
+    
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, task_thread, start) != 0) {
+        free(start);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    if (out) *out = (TaskHandle_t)start;    // Opaque; never dereferenced
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (!task) pthread_exit(NULL);
+}
+
+// ============================================================================
+// SEMAPHORES
+// ============================================================================
+
+struct semaphore {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool given;
+};
+
+static SemaphoreHandle_t semaphore_create(bool given) {
+    SemaphoreHandle_t sem = calloc(1, sizeof(*sem));
+    if (!sem) return NULL;
+    pthread_mutex_init(&sem->mutex, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->given = given;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return semaphore_create(false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return semaphore_create(true);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    struct timespec deadline = deadline_in(ticks);
+    pthread_mutex_lock(&sem->mutex);
+    while (!sem->given && wait_cond(&sem->cond, &sem->mutex, ticks, &deadline)) {}
+    bool taken = sem->given;
+    sem->given = false;
+    pthread_mutex_unlock(&sem->mutex);
+    return taken ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    pthread_mutex_lock(&sem->mutex);
+    bool was_given = sem->given;
+    sem->given = true;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+    return was_given ? pdFALSE : pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    if (!sem) return;
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->mutex);
+    free(sem);
+}
+
+// ============================================================================
+// QUEUES
+// ============================================================================
+
+struct queue {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+    if (!queue) return NULL;
+    queue->items = malloc((size_t)length * item_size);
+    if (!queue->items) {
+        free(queue);
+        return NULL;
+    }
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    struct timespec deadline = deadline_in(ticks);
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == queue->length &&
+           wait_cond(&queue->changed, &queue->mutex, ticks, &deadline)) {}
+    bool sent = queue->count < queue->length;
+    if (sent) {
+        UBaseType_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(&queue->items[(size_t)tail * queue->item_size], item, queue->item_size);
+        queue->count++;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return sent ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    struct timespec deadline = deadline_in(ticks);
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == 0 && wait_cond(&queue->changed, &queue->mutex, ticks, &deadline)) {}
+    bool received = queue->count > 0;
+    if (received) {
+        memcpy(item, &queue->items[(size_t)queue->head * queue->item_size], queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return received ? pdTRUE : pdFALSE;
+}
@@ -0,0 +1,3 @@
+/*
+ * ESP-IDF stand-in for host tests: no project configuration
+ */
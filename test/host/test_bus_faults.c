@@ -0,0 +1,124 @@
+/*
+ * Flushes on a faulty bus
+ * Injects NACKs, timeouts and a stuck SDA line into every transaction
+ * while drawing, in both flush modes, blocking and async. Each error must
+ * be counted once and every stuck bus cleared, and whenever the faults
+ * stop, one more update must leave the panel holding exactly the frame
+ * buffer. Also checks that pages changing every frame, enough to run each
+ * flush into its deadline, can't keep the pages below them off the panel.
+ */
+
+#include "host_test.h"
+#include "ssd1306.h"
+#include "ssd1306_hostbus.h"
+#include <string.h>
+
+#define FRAMES       2000
+#define CHECK_EVERY  100        // Frames between checks of the panel
+#define CYCLE        5          // Distinct frames drawn
+#define STARVE_PAGES 3          // Top pages redrawn whole every frame
+#define STARVE_LIMIT 8          // Frames the bottom pages may take
+
+static void run(ssd1306_flush_mode_t mode, bool async, uint32_t seed) {
+    host_test_reset();
+    ssd1306_set_flush_mode(mode);
+    
+    ssd1306_bus_stats_t before, after;
+    ssd1306_get_bus_stats(&before);
+    
+    for (int n = 0; n < FRAMES; n++) {
+        if (n % CHECK_EVERY == 0) {
+            hostbus_faults_t faults = {
+                .nack_per_mille = 50,
+                .timeout_per_mille = 30,
+                .stuck_per_mille = 10,
+                .seed = seed + n,
+            };
+            hostbus_set_faults(&faults);
+        }
+        
+        // A short cycle of frames, so pages often go back to what the
+        // driver last knew the panel held while a failed write had left
+        // something else there
+        host_test_draw_frame(n % CYCLE);
+        if (async) {
+            ssd1306_present_async();
+        } else {
+            ssd1306_update();
+        }
+        
+        if ((n + 1) % CHECK_EVERY == 0) {
+            // Whatever the faults left behind goes out with the next update
+            ssd1306_wait_idle();
+            hostbus_set_faults(NULL);
+            CHECK(host_test_flush());
+            CHECK(host_test_panel_matches());
+        }
+    }
+    
+    ssd1306_get_bus_stats(&after);
+    hostbus_stats_t wire;
+    hostbus_get_stats(&wire);
+    
+    // Every fault hit, and the driver saw each one once
+    CHECK(wire.nacks > 0);
+    CHECK(wire.timeouts > 0);
+    CHECK(wire.bus_resets > 0);
+    CHECK_EQ(after.nacks - before.nacks, wire.nacks);
+    CHECK_EQ(after.timeouts - before.timeouts, wire.timeouts);
+    CHECK_EQ((after.bus_resets - before.bus_resets) +
+             (after.controller_resets - before.controller_resets), wire.bus_resets);
+    
+    printf("%s %-5s: %lu NACKs, %lu timeouts, %lu bus resets, %lu controller resets, "
+           "%lu deadline aborts\n",
+           (mode == SSD1306_FLUSH_SINGLE) ? "single " : "chunked", async ? "async" : "sync",
+           (unsigned long)wire.nacks, (unsigned long)wire.timeouts,
+           (unsigned long)(after.bus_resets - before.bus_resets),
+           (unsigned long)(after.controller_resets - before.controller_resets),
+           (unsigned long)(after.deadline_aborts - before.deadline_aborts));
+}
+
+// Redraw the top pages whole every frame, which takes the flush past its
+// deadline, and check that the bottom pages, drawn once, still get out
+static void run_starve(bool async) {
+    host_test_reset();
+    
+    ssd1306_bus_stats_t before, after;
+    ssd1306_get_bus_stats(&before);
+    
+    for (int x = 0; x < 128; x += 16) {
+        ssd1306_fill_rect(x, 40 + (x / 16) % 3 * 8, 8, 8, true);
+    }
+    const uint8_t *ram = hostbus_get_ram();
+    const uint8_t *buf = ssd1306_get_buffer();
+    const size_t bottom = 5 * SSD1306_WIDTH;
+    
+    int frames = 0;
+    for (int n = 0; n < STARVE_LIMIT; n++) {
+        ssd1306_fill_rect(0, 0, 128, STARVE_PAGES * 8, n % 2 == 0);
+        if (async) {
+            ssd1306_present_async();
+        } else {
+            ssd1306_update();
+        }
+        ssd1306_wait_idle();
+        frames = n + 1;
+        if (memcmp(&ram[bottom], &buf[bottom], 3 * SSD1306_WIDTH) == 0) break;
+    }
+    
+    ssd1306_get_bus_stats(&after);
+    CHECK(after.deadline_aborts > before.deadline_aborts);
+    CHECK(memcmp(&ram[bottom], &buf[bottom], 3 * SSD1306_WIDTH) == 0);
+    printf("starve  %-5s: bottom pages out after %d frames\n", async ? "async" : "sync", frames);
+}
+
+int main(void) {
+    host_test_init();
+    run(SSD1306_FLUSH_CHUNKED, false, 1);
+    run(SSD1306_FLUSH_CHUNKED, true, 2);
+    run(SSD1306_FLUSH_SINGLE, false, 3);
+    run(SSD1306_FLUSH_SINGLE, true, 4);
+    run_starve(false);
+    run_starve(true);
+    return 0;
+}
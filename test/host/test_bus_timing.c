@@ -0,0 +1,109 @@
+/*
+ * Bus benchmark against the wire timing model
+ * With the panel limited to 400 kHz, ssd1306_benchmark() must find the
+ * rates above it unreliable, time the others as the model charges them,
+ * pick 400 kHz and leave what the panel shows untouched.
+ */
+
+#include "host_test.h"
+#include "ssd1306.h"
+#include "ssd1306_hostbus.h"
+#include <string.h>
+
+#define RAM_BYTES  (SSD1306_WIDTH * SSD1306_HEIGHT / 8)
+
+static const hostbus_timing_t timing = {
+    .txn_overhead_us = 50,
+    .byte_gap_ns = 2000,
+    .max_scl_hz = 400000,
+};
+
+// Modeled time of one timed transfer: the window command (address byte,
+// control byte and 6 command bytes) and the data write (address byte,
+// control byte and the pages)
+static uint32_t model_us(uint32_t scl_hz, int pages) {
+    uint64_t byte_ns = 9ULL * 1000000000ULL / scl_hz + timing.byte_gap_ns;
+    uint64_t bytes = 8 + 2 + pages * SSD1306_WIDTH;
+    return (uint32_t)((2ULL * timing.txn_overhead_us * 1000 + bytes * byte_ns) / 1000);
+}
+
+// Draw something to keep, and take a copy of the panel
+static void show_frame(uint8_t *ram) {
+    host_test_reset();
+    host_test_draw_frame(7);
+    CHECK(host_test_flush());
+    memcpy(ram, hostbus_get_ram(), RAM_BYTES);
+}
+
+static void test_selects_fastest_reliable(void) {
+    uint8_t ram[RAM_BYTES];
+    show_frame(ram);
+    hostbus_set_timing(&timing);
+    
+    ssd1306_bench_result_t result;
+    CHECK(ssd1306_benchmark(&result, true) == ESP_OK);
+    CHECK_EQ(result.selected_hz, 400000);
+    CHECK_EQ(ssd1306_get_bus_speed(), 400000);
+    
+    for (int i = 0; i < SSD1306_BENCH_RATES; i++) {
+        const ssd1306_bench_rate_t *rate = &result.rates[i];
+        if (rate->scl_hz > timing.max_scl_hz) {
+            CHECK(!rate->reliable);
+            CHECK_EQ(rate->frames_per_s, 0);
+            continue;
+        }
+        CHECK(rate->reliable);
+        // Averaged over whole microseconds, so allow for rounding
+        CHECK(rate->full_us + 1 >= model_us(rate->scl_hz, 8) &&
+              rate->full_us <= model_us(rate->scl_hz, 8) + 1);
+        CHECK(rate->partial_us + 1 >= model_us(rate->scl_hz, 1) &&
+              rate->partial_us <= model_us(rate->scl_hz, 1) + 1);
+        CHECK_EQ(rate->frames_per_s, 1000000 / rate->full_us);
+    }
+    CHECK(result.rates[0].full_us > result.rates[1].full_us);
+    
+    // Rewritten with what it held; refused writes never reached it
+    CHECK(memcmp(hostbus_get_ram(), ram, RAM_BYTES) == 0);
+    CHECK(host_test_panel_matches());
+    
+    // And it keeps working at the rate chosen
+    host_test_draw_frame(8);
+    CHECK(host_test_flush());
+    CHECK(host_test_panel_matches());
+}
+
+static void test_keeps_rate_unless_applied(void) {
+    uint8_t ram[RAM_BYTES];
+    show_frame(ram);
+    CHECK(ssd1306_set_bus_speed(100000) == ESP_OK);
+    hostbus_set_timing(&timing);
+    
+    ssd1306_bench_result_t result;
+    CHECK(ssd1306_benchmark(&result, false) == ESP_OK);
+    CHECK_EQ(result.selected_hz, 400000);
+    CHECK_EQ(ssd1306_get_bus_speed(), 100000);
+    CHECK(memcmp(hostbus_get_ram(), ram, RAM_BYTES) == 0);
+}
+
+static void test_no_reliable_rate(void) {
+    uint8_t ram[RAM_BYTES];
+    show_frame(ram);
+    hostbus_timing_t slow = timing;
+    slow.max_scl_hz = 50000;
+    hostbus_set_timing(&slow);
+    
+    ssd1306_bench_result_t result;
+    CHECK(ssd1306_benchmark(&result, true) == ESP_FAIL);
+    CHECK_EQ(result.selected_hz, 0);
+    for (int i = 0; i < SSD1306_BENCH_RATES; i++) CHECK(!result.rates[i].reliable);
+    CHECK_EQ(ssd1306_get_bus_speed(), SSD1306_I2C_SPEED_HZ);
+    CHECK(memcmp(hostbus_get_ram(), ram, RAM_BYTES) == 0);
+}
+
+int main(void) {
+    host_test_init();
+    test_selects_fastest_reliable();
+    test_keeps_rate_unless_applied();
+    test_no_reliable_rate();
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Frame stream round trip
+ * Streams the driver's flushes into a FIFO read by the decoder tool
+ * (tools/framestream_decode.c, path given as the only argument) and
+ * checks every frame it writes out against the emulated panel RAM at the
+ * time the frame was sent, in both flush modes, blocking and async.
+ */
+
+#include "host_test.h"
+#include "ssd1306.h"
+#include "ssd1306_hostbus.h"
+#include "framestream.h"
+#include <spawn.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+// Spans the key frame interval, so the stream carries deltas and keys
+#define FRAMES        (2 * FRAMESTREAM_KEYFRAME_INTERVAL + 40)
+#define FRAME_PIXELS  (SSD1306_WIDTH * SSD1306_HEIGHT)
+
+// Panel RAM as the decoder writes raw frames: one byte per pixel,
+// row-major, 0xFF lit
+static void expand_ram(uint8_t *out) {
+    const uint8_t *ram = hostbus_get_ram();
+    for (int y = 0; y < SSD1306_HEIGHT; y++) {
+        for (int x = 0; x < SSD1306_WIDTH; x++) {
+            bool on = (ram[(y / 8) * SSD1306_WIDTH + x] >> (y & 7)) & 1;
+            *out++ = on ? 0xFF : 0x00;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    CHECK(argc == 2);
+    host_test_init();
+    host_test_reset();
+    
+    char dir[] = "/tmp/framestream_XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+    char fifo[64], out[64];
+    snprintf(fifo, sizeof(fifo), "%s/stream", dir);
+    snprintf(out, sizeof(out), "%s/frames.raw", dir);
+    CHECK(mkfifo(fifo, 0600) == 0);
+    
+    // Each end's open waits for the other
+    char *decoder_args[] = {argv[1], "-o", out, fifo, NULL};
+    pid_t decoder;
+    CHECK(posix_spawn(&decoder, argv[1], NULL, NULL, decoder_args, environ) == 0);
+    CHECK(framestream_start_file(fifo) == ESP_OK);
+    
+    // Every present here changes pages, so each one sends a frame, but a
+    // flush cut short by the deadline sends what it got through as one too
+    uint8_t *expected = malloc((size_t)FRAMES * FRAME_PIXELS);
+    CHECK(expected != NULL);
+    int count = 0;
+    for (int n = 0; n < FRAMES; n++) {
+        int quarter = n * 4 / FRAMES;
+        bool async = quarter & 1;
+        ssd1306_set_flush_mode((quarter & 2) ? SSD1306_FLUSH_SINGLE : SSD1306_FLUSH_CHUNKED);
+        
+        framestream_stats_t before, after;
+        framestream_get_stats(&before);
+        host_test_draw_frame(n);
+        if (async) {
+            ssd1306_present_async();
+            ssd1306_wait_idle();
+        } else {
+            ssd1306_update();
+        }
+        framestream_get_stats(&after);
+        
+        CHECK_EQ(after.frames, before.frames + 1);
+        expand_ram(&expected[(size_t)count++ * FRAME_PIXELS]);
+    }
+    
+    framestream_stop();
+    int status;
+    CHECK(waitpid(decoder, &status, 0) == decoder);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    
+    // The decoder writes a frame once it has seen a key frame, which the
+    // stream starts with, so it must have written every one
+    FILE *f = fopen(out, "rb");
+    CHECK(f != NULL);
+    uint8_t *frame = malloc(FRAME_PIXELS);
+    CHECK(frame != NULL);
+    for (int i = 0; i < count; i++) {
+        CHECK_EQ(fread(frame, 1, FRAME_PIXELS, f), FRAME_PIXELS);
+        if (memcmp(frame, &expected[(size_t)i * FRAME_PIXELS], FRAME_PIXELS) != 0) {
+            fprintf(stderr, "frame %d differs from the panel\n", i);
+            exit(1);
+        }
+    }
+    CHECK(fgetc(f) == EOF);
+    fclose(f);
+    
+    framestream_stats_t stats;
+    framestream_get_stats(&stats);
+    printf("%d frames, %lu bytes, %lu key frames\n", count,
+           (unsigned long)stats.bytes, (unsigned long)stats.key_frames);
+    
+    unlink(out);
+    unlink(fifo);
+    rmdir(dir);
+    free(frame);
+    free(expected);
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * Gray mode plane scheduler
+ * The slot timer must show the high plane for two slots and the low plane
+ * for one, at one slot per SSD1306_GRAY_SLOT_US, and count a plane as
+ * sent only once all of it reached the panel.
+ */
+
+#include "host_test.h"
+#include "ssd1306.h"
+#include "ssd1306_hostbus.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define RUN_MS  300
+
+// What the panel showed at pixel (0, 0), watched from the flush task
+typedef struct {
+    int last;
+    uint32_t lit;               // Times it went on (low plane shown)
+    uint32_t changes;
+} watch_t;
+
+static void watch_pixel(uint8_t i2c_addr, void *arg) {
+    watch_t *w = arg;
+    if (i2c_addr != HOST_TEST_ADDR) return;
+    int on = hostbus_get_ram()[0] & 1;
+    if (on == w->last) return;
+    w->changes++;
+    if (on) w->lit++;
+    w->last = on;
+}
+
+// A dark square: off in the high plane, on in the low one, so the panel
+// shows it lit one slot in three
+static void test_planes_alternate(void) {
+    host_test_reset();
+    watch_t watch = {0};
+    hostbus_set_write_hook(watch_pixel, &watch);
+    
+    CHECK(ssd1306_set_gray_mode(true) == ESP_OK);
+    ssd1306_fill_rect_gray(0, 0, 8, 8, SSD1306_GRAY_DARK);
+    CHECK(ssd1306_update() == ESP_OK);
+    vTaskDelay(pdMS_TO_TICKS(RUN_MS));
+    
+    ssd1306_gray_stats_t stats;
+    ssd1306_get_gray_stats(&stats);
+    uint32_t rate_hz = stats.plane_rate_hz;
+    CHECK(ssd1306_set_gray_mode(false) == ESP_OK);
+    hostbus_set_write_hook(NULL, NULL);
+    ssd1306_get_gray_stats(&stats);
+    
+    // Each slot either sent its plane or found the bus busy; the small
+    // square never runs into the deadline
+    CHECK(stats.slots >= 10);
+    CHECK(stats.planes_sent + stats.dropped <= stats.slots);
+    CHECK(stats.planes_sent + stats.dropped + 1 >= stats.slots);
+    CHECK(stats.planes_sent > stats.slots / 2);
+    
+    // One low plane in three (less any dropped), each shown once and
+    // replaced by a high one
+    CHECK(watch.lit * 3 <= stats.planes_sent + 3);
+    CHECK((watch.lit + stats.dropped) * 3 + 3 >= stats.planes_sent);
+    CHECK(watch.changes + 1 >= 2 * watch.lit && watch.changes <= 2 * watch.lit);
+    
+    // Rate: at most one plane per slot, and not far below with the bus free
+    uint32_t slot_hz = 1000000 / SSD1306_GRAY_SLOT_US;
+    CHECK(rate_hz <= slot_hz + slot_hz / 10);
+    CHECK(rate_hz >= slot_hz / 2);
+    
+    printf("planes: %lu slots, %lu sent, %lu dropped, %lu Hz, lit %lu times\n",
+           (unsigned long)stats.slots, (unsigned long)stats.planes_sent,
+           (unsigned long)stats.dropped, (unsigned long)rate_hz, (unsigned long)watch.lit);
+}
+
+// Gray over the whole screen: each plane differs from the last on every
+// page, more than fits in the flush deadline
+static void test_cut_planes_not_counted(void) {
+    host_test_reset();
+    ssd1306_bus_stats_t before, after;
+    ssd1306_get_bus_stats(&before);
+    
+    CHECK(ssd1306_set_gray_mode(true) == ESP_OK);
+    ssd1306_fill_rect_gray(0, 0, SSD1306_WIDTH, SSD1306_HEIGHT, SSD1306_GRAY_DARK);
+    CHECK(ssd1306_update() == ESP_OK);
+    vTaskDelay(pdMS_TO_TICKS(RUN_MS / 3));
+    CHECK(ssd1306_set_gray_mode(false) == ESP_OK);
+    
+    ssd1306_gray_stats_t stats;
+    ssd1306_get_gray_stats(&stats);
+    ssd1306_get_bus_stats(&after);
+    
+    // A low plane never gets out whole, nor does the high plane after it.
+    // The second high slot in a row finds the top pages already done and
+    // finishes the rest, so past the first two high slots (all black, as
+    // the panel already was) only one slot in three counts, plus one for
+    // each low slot dropped while the bus was busy.
+    CHECK(stats.slots >= 6);
+    CHECK(stats.planes_sent * 3 <= stats.slots + 6 + 3 * stats.dropped);
+    CHECK(after.deadline_aborts - before.deadline_aborts + stats.planes_sent +
+          stats.dropped + 1 >= stats.slots);
+}
+
+int main(void) {
+    host_test_init();
+    test_planes_alternate();
+    test_cut_planes_not_counted();
+    return 0;
+}
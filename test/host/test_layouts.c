@@ -0,0 +1,110 @@
+/*
+ * Page and row-major frame buffer layouts
+ * Built twice, against the driver in each layout (SSD1306_ROW_MAJOR). Run
+ * with --dump, it draws a sequence of frames and writes what the panel
+ * holds after each one to stdout. Run with the path of the page-layout
+ * build, it draws the same frames itself and checks the panel against
+ * that build's dump frame by frame, then reports the draw and flush cost
+ * of each layout.
+ */
+
+#include "host_test.h"
+#include "ssd1306.h"
+#include "ssd1306_hostbus.h"
+#include "esp_timer.h"
+#include <string.h>
+
+#define FRAMES     300
+#define RAM_BYTES  (SSD1306_WIDTH * SSD1306_HEIGHT / 8)
+
+static uint8_t glyph_data[2 * 13];
+static const bitmap_t glyph = {13, 11, glyph_data};
+
+static uint8_t dither_row(int y, void *user) {
+    (void)user;
+    return (y & 1) ? 0xAA : 0x55;
+}
+
+// Frame n: every primitive at shifting positions and alignments. Every
+// fourth frame only adds to the last, so just some pages are redrawn.
+static void draw_frame(int n) {
+    if (n % 4 != 3) ssd1306_clear();
+    
+    ssd1306_fill_rect((n * 7) % 120 - 4, (n * 5) % 60 - 2, 13 + n % 9, 9 + n % 7, true);
+    ssd1306_fill_rect(20 + n % 11, 10 + n % 13, 30, 3, false);
+    ssd1306_hline(n % 17 - 3, (n * 3) % 64, 40 + n % 50, true);
+    ssd1306_vline((n * 11) % 128, n % 20 - 5, 30, true);
+    ssd1306_hline_pattern(5 + n % 9, 40 + n % 20, 70, (uint8_t)(0x5A ^ n));
+    ssd1306_fill_circle(30 + (n * 3) % 70, 20 + n % 30, 4 + n % 9, true);
+    ssd1306_draw_circle(90 - n % 40, 35, 3 + n % 12, true);
+    ssd1306_fill_ellipse(64, 32, 10 + n % 20, 5 + n % 11, n % 2);
+    ssd1306_fill_ellipse_pattern(100 - n % 30, 15 + n % 40, 9, 6, dither_row, NULL);
+    ssd1306_draw_ellipse(50, 40 - n % 10, 20, 8 + n % 5, true);
+    
+    if (ssd1306_push_clip(10 + n % 7, 5, 90, 50)) {
+        ssd1306_blit(&glyph, (n * 13) % 130 - 10, (n * 7) % 70 - 8, (ssd1306_rop_t)(n % 5));
+        ssd1306_fill_circle(n % 128, 30, 12, n % 3 == 0);
+        ssd1306_pop_clip();
+    }
+    for (int i = 0; i < 40; i++) {
+        ssd1306_set_pixel((n * 31 + i * 17) % 140 - 6, (n * 13 + i * 7) % 70 - 3, i % 3 != 0);
+    }
+}
+
+// Draw and update every frame, handing the panel to each() after it
+static void run(void (*each)(int n, const uint8_t *ram, void *arg), void *arg,
+                int64_t *draw_us, int64_t *flush_us) {
+    host_test_reset();
+    *draw_us = *flush_us = 0;
+    for (int n = 0; n < FRAMES; n++) {
+        int64_t t0 = esp_timer_get_time();
+        draw_frame(n);
+        int64_t t1 = esp_timer_get_time();
+        CHECK(host_test_flush());
+        *draw_us += t1 - t0;
+        *flush_us += esp_timer_get_time() - t1;
+        CHECK(host_test_panel_matches());
+        each(n, hostbus_get_ram(), arg);
+    }
+}
+
+static void dump_frame(int n, const uint8_t *ram, void *arg) {
+    (void)n;
+    (void)arg;
+    CHECK(fwrite(ram, 1, RAM_BYTES, stdout) == RAM_BYTES);
+}
+
+static void compare_frame(int n, const uint8_t *ram, void *arg) {
+    uint8_t expect[RAM_BYTES];
+    CHECK(fread(expect, 1, RAM_BYTES, (FILE *)arg) == RAM_BYTES);
+    if (memcmp(ram, expect, RAM_BYTES) != 0) {
+        fprintf(stderr, "frame %d differs from the page layout\n", n);
+        exit(1);
+    }
+}
+
+int main(int argc, char **argv) {
+    for (int i = 0; i < (int)sizeof(glyph_data); i++) glyph_data[i] = (uint8_t)(i * 97 + 13);
+    host_test_init();
+    int64_t draw_us, flush_us;
+    
+    if (argc == 2 && strcmp(argv[1], "--dump") == 0) {
+        CHECK(!SSD1306_ROW_MAJOR);
+        run(dump_frame, NULL, &draw_us, &flush_us);
+        fprintf(stderr, "page layout:      draw %3lld us, flush %3lld us per frame\n",
+                (long long)(draw_us / FRAMES), (long long)(flush_us / FRAMES));
+        return 0;
+    }
+    
+    CHECK(argc == 2 && SSD1306_ROW_MAJOR);
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "'%s' --dump", argv[1]);
+    FILE *page = popen(cmd, "r");
+    CHECK(page != NULL);
+    run(compare_frame, page, &draw_us, &flush_us);
+    CHECK(fgetc(page) == EOF);
+    CHECK(pclose(page) == 0);
+    fprintf(stderr, "row-major layout: draw %3lld us, flush %3lld us per frame\n",
+            (long long)(draw_us / FRAMES), (long long)(flush_us / FRAMES));
+    return 0;
+}
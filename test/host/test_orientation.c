@@ -0,0 +1,73 @@
+/*
+ * Rotation and mirroring
+ * Draws a glyph with no symmetry in each of the 8 orientations and checks
+ * every pixel as it appears on screen: turned clockwise by the rotation,
+ * after a left-right flip of the canvas when mirrored.
+ */
+
+#include "host_test.h"
+#include "ssd1306.h"
+#include "ssd1306_hostbus.h"
+
+// An F with a dot off its lower right, near the canvas's top left corner,
+// and a bar along the bottom edge so the far corner is covered too
+static void draw_glyph(void) {
+    int w = ssd1306_get_width(), h = ssd1306_get_height();
+    ssd1306_clear();
+    ssd1306_vline(3, 2, 12, true);
+    ssd1306_hline(3, 2, 8, true);
+    ssd1306_hline(3, 7, 5, true);
+    ssd1306_set_pixel(9, 12, true);
+    ssd1306_hline(w - 6, h - 1, 6, true);
+}
+
+// Where canvas pixel (x, y) shows on the 128x64 screen
+static void to_screen(ssd1306_orientation_t rotation, bool mirror, int x, int y,
+                      int *sx, int *sy) {
+    int w = ssd1306_get_width(), h = ssd1306_get_height();
+    if (mirror) x = w - 1 - x;
+    switch (rotation) {
+        case SSD1306_ROT_0:   *sx = x;         *sy = y;         break;
+        case SSD1306_ROT_90:  *sx = h - 1 - y; *sy = x;         break;
+        case SSD1306_ROT_180: *sx = w - 1 - x; *sy = h - 1 - y; break;
+        case SSD1306_ROT_270: *sx = y;         *sy = w - 1 - x; break;
+    }
+}
+
+static void check_orientation(ssd1306_orientation_t rotation, bool mirror) {
+    CHECK(ssd1306_set_orientation(rotation, mirror) == ESP_OK);
+    bool portrait = (rotation == SSD1306_ROT_90 || rotation == SSD1306_ROT_270);
+    CHECK_EQ(ssd1306_get_width(), portrait ? SSD1306_HEIGHT : SSD1306_WIDTH);
+    CHECK_EQ(ssd1306_get_height(), portrait ? SSD1306_WIDTH : SSD1306_HEIGHT);
+    
+    draw_glyph();
+    CHECK(host_test_flush());
+    ssd1306_wait_idle();
+    
+    int lit = 0;
+    for (int y = 0; y < ssd1306_get_height(); y++) {
+        for (int x = 0; x < ssd1306_get_width(); x++) {
+            int sx = 0, sy = 0;
+            to_screen(rotation, mirror, x, y, &sx, &sy);
+            bool on = ssd1306_get_pixel(x, y);
+            if (hostbus_get_screen_pixel(sx, sy) != on) {
+                fprintf(stderr, "rotation %d%s: canvas (%d, %d) should show at (%d, %d)\n",
+                        rotation * 90, mirror ? " mirrored" : "", x, y, sx, sy);
+                exit(1);
+            }
+            lit += on;
+        }
+    }
+    CHECK_EQ(lit, 12 + 8 + 5 + 1 + 6 - 2);
+}
+
+int main(void) {
+    host_test_init();
+    host_test_reset();
+    for (int rotation = SSD1306_ROT_0; rotation <= SSD1306_ROT_270; rotation++) {
+        check_orientation(rotation, false);
+        check_orientation(rotation, true);
+    }
+    CHECK(ssd1306_set_orientation(SSD1306_ROT_0, false) == ESP_OK);
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * Continuous horizontal scroll
+ * The panel must move the band one column per step while the pages
+ * around it stay put, and must take no display RAM writes while the
+ * scroll runs: frames drawn meanwhile show only once it stops.
+ */
+
+#include "host_test.h"
+#include "ssd1306.h"
+#include "ssd1306_hostbus.h"
+#include <string.h>
+
+#define RAM_BYTES  (SSD1306_WIDTH * SSD1306_HEIGHT / 8)
+#define BAND       0xC0         // Pages 6-7
+#define BAND_START (6 * SSD1306_WIDTH)
+#define STEP       2            // Panel frames per column
+#define STEPS      5
+
+// Whether the band holds the frame's band turned left by steps columns,
+// and the pages above it the frame as it was
+static bool band_turned(const uint8_t *frame, int steps) {
+    const uint8_t *ram = hostbus_get_ram();
+    if (memcmp(ram, frame, BAND_START) != 0) return false;
+    for (int i = BAND_START; i < RAM_BYTES; i++) {
+        int page = i / SSD1306_WIDTH, col = i % SSD1306_WIDTH;
+        if (ram[i] != frame[page * SSD1306_WIDTH + (col + steps) % SSD1306_WIDTH]) return false;
+    }
+    return true;
+}
+
+// Draw a frame with an asymmetric mark in the band and scroll the band
+static void start(uint8_t *frame) {
+    host_test_reset();
+    host_test_draw_frame(3);
+    ssd1306_fill_rect(0, 48, 10, 16, true);
+    ssd1306_fill_rect(20, 56, 3, 8, true);
+    memcpy(frame, ssd1306_get_buffer(), RAM_BYTES);
+    
+    CHECK(ssd1306_start_scroll(6, 7, SSD1306_SCROLL_LEFT, STEP) == ESP_OK);
+    CHECK_EQ(ssd1306_get_scroll_pages(), BAND);
+    CHECK_EQ(hostbus_get_scroll_pages(), BAND);
+    CHECK(memcmp(hostbus_get_ram(), frame, RAM_BYTES) == 0);
+}
+
+static void test_band_scrolls(void) {
+    uint8_t frame[RAM_BYTES];
+    start(frame);
+    
+    // Half a step moves nothing, then one column per step
+    hostbus_advance_frames(STEP - 1);
+    CHECK(band_turned(frame, 0));
+    hostbus_advance_frames(1);
+    CHECK(band_turned(frame, 1));
+    hostbus_advance_frames(STEP * (STEPS - 1));
+    CHECK(band_turned(frame, STEPS));
+    
+    // A whole turn brings the band back
+    hostbus_advance_frames(STEP * (SSD1306_WIDTH - STEPS));
+    CHECK(band_turned(frame, 0));
+    
+    CHECK(ssd1306_stop_scroll() == ESP_OK);
+    CHECK_EQ(hostbus_get_scroll_pages(), 0);
+    CHECK(host_test_flush());
+    CHECK(host_test_panel_matches());
+}
+
+static void test_writes_held(void) {
+    uint8_t frame[RAM_BYTES];
+    start(frame);
+    hostbus_advance_frames(STEP * STEPS);
+    hostbus_reset_stats();
+    
+    // New frames, blocking and async, leave display RAM alone
+    host_test_draw_frame(4);
+    CHECK(ssd1306_update() == ESP_OK);
+    host_test_draw_frame(5);
+    ssd1306_present_async();
+    ssd1306_wait_idle();
+    CHECK(band_turned(frame, STEPS));
+    
+    hostbus_stats_t wire;
+    hostbus_get_stats(&wire);
+    CHECK_EQ(wire.scroll_writes, 0);
+    CHECK_EQ(wire.data_bytes, 0);
+    
+    // Stopping rewrites the band and brings the held frame out
+    CHECK(ssd1306_stop_scroll() == ESP_OK);
+    CHECK(host_test_flush());
+    CHECK(host_test_panel_matches());
+    hostbus_get_stats(&wire);
+    CHECK_EQ(wire.scroll_writes, 0);
+}
+
+int main(void) {
+    host_test_init();
+    test_band_scrolls();
+    test_writes_held();
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Two panels on one bus
+ * Frames presented to both panels go out interleaved by the flush task,
+ * and with a full frame taking longer than the flush deadline, most are
+ * cut short and finished by later flushes. The second panel runs in
+ * portrait, where the canvas dirty mask counts canvas rows rather than
+ * panel pages, and mixes blocking updates in with its presents. Whenever
+ * both are flushed through, each panel must hold exactly its own frame.
+ */
+
+#include "host_test.h"
+#include "ssd1306.h"
+#include "ssd1306_hostbus.h"
+#include <string.h>
+
+#define SECOND_ADDR  0x3D
+#define FRAMES       400
+#define CHECK_EVERY  20
+#define CYCLE        5
+#define RAM_BYTES    (SSD1306_WIDTH * SSD1306_HEIGHT / 8)
+#define FLUSH_TRIES  16
+
+static ssd1306_t *second;
+
+// Portrait frame n for the second panel: shapes that move down the
+// 64x128 canvas, so its dirty rows change from frame to frame
+static void draw_second(int n) {
+    ssd1306_dev_clear(second);
+    ssd1306_dev_fill_rect(second, 4, (n * 11) % 112, 24, 16, true);
+    ssd1306_dev_fill_circle(second, 40, 20 + (n * 7) % 88, 10, true);
+    ssd1306_dev_hline(second, 0, (n * 3) % 128, 64, true);
+}
+
+static bool flush_second(void) {
+    for (int i = 0; i < FLUSH_TRIES; i++) {
+        if (ssd1306_dev_update(second) == ESP_OK) return true;
+    }
+    return false;
+}
+
+static bool panel_holds(uint8_t i2c_addr, const uint8_t *frame) {
+    hostbus_select(i2c_addr);
+    bool same = memcmp(hostbus_get_ram(), frame, RAM_BYTES) == 0;
+    hostbus_select(HOST_TEST_ADDR);
+    return same;
+}
+
+int main(void) {
+    host_test_init();
+    CHECK(ssd1306_dev_init(&second, -1, -1, SECOND_ADDR) == ESP_OK);
+    CHECK(ssd1306_dev_set_orientation(second, SSD1306_ROT_90, false) == ESP_OK);
+    CHECK_EQ(ssd1306_dev_get_height(second), 128);
+    host_test_reset();
+    CHECK(flush_second());
+    
+    ssd1306_bus_stats_t before, after;
+    ssd1306_get_bus_stats(&before);
+    
+    for (int n = 0; n < FRAMES; n++) {
+        host_test_draw_frame(n % CYCLE);
+        draw_second(n % CYCLE);
+        ssd1306_present_async();
+        if (n % 2) {
+            ssd1306_dev_present_async(second);
+        } else {
+            ssd1306_dev_update(second);
+        }
+        
+        if ((n + 1) % CHECK_EVERY == 0) {
+            ssd1306_dev_wait_idle(second);
+            CHECK(host_test_flush());
+            CHECK(flush_second());
+            CHECK(panel_holds(HOST_TEST_ADDR, ssd1306_get_buffer()));
+            CHECK(panel_holds(SECOND_ADDR, ssd1306_dev_get_buffer(second)));
+        }
+    }
+    
+    // The frames were big enough to be cut short
+    ssd1306_get_bus_stats(&after);
+    CHECK(after.deadline_aborts > before.deadline_aborts);
+    printf("%lu deadline aborts over %d frames\n",
+           (unsigned long)(after.deadline_aborts - before.deadline_aborts), FRAMES);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * Vertical offset
+ * The panel's start line must move the whole picture along the panel's
+ * rows, down the canvas in landscape and across it in portrait, with the
+ * rows it wraps to the other edge showing the blank band the app draws
+ * there (ssd1306_get_offset_wrap, as add_face_items does for the panel
+ * shift) instead of the far side of the face.
+ */
+
+#include "host_test.h"
+#include "ssd1306.h"
+#include "ssd1306_hostbus.h"
+
+// The app's background, which the band is filled with
+#define BACKGROUND  true
+
+static const int offsets[] = {5, -7, 63, -1, 0};
+
+// Every canvas pixel distinct enough from its neighbours that a picture
+// off by a row or column shows
+static bool pattern(int x, int y) {
+    return ((x * 5 + y * 3 + (x ^ y)) % 7) < 3;
+}
+
+// Where canvas pixel (x, y) shows on the 128x64 screen with no offset
+static void to_screen(ssd1306_orientation_t rotation, bool mirror, int x, int y,
+                      int *sx, int *sy) {
+    int w = ssd1306_get_width(), h = ssd1306_get_height();
+    if (mirror) x = w - 1 - x;
+    switch (rotation) {
+        case SSD1306_ROT_0:   *sx = x;         *sy = y;         break;
+        case SSD1306_ROT_90:  *sx = h - 1 - y; *sy = x;         break;
+        case SSD1306_ROT_180: *sx = w - 1 - x; *sy = h - 1 - y; break;
+        case SSD1306_ROT_270: *sx = y;         *sy = w - 1 - x; break;
+    }
+}
+
+static void check_offset(ssd1306_orientation_t rotation, bool mirror, int rows) {
+    bool portrait = (rotation == SSD1306_ROT_90 || rotation == SSD1306_ROT_270);
+    int w = ssd1306_get_width(), h = ssd1306_get_height();
+    
+    ssd1306_clear();
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (pattern(x, y)) ssd1306_set_pixel(x, y, true);
+        }
+    }
+    int bx, by, bw, bh;
+    ssd1306_get_offset_wrap(rows, &bx, &by, &bw, &bh);
+    ssd1306_fill_rect(bx, by, bw, bh, BACKGROUND);
+    ssd1306_set_vertical_offset(rows);
+    CHECK(host_test_flush());
+    ssd1306_wait_idle();
+    CHECK_EQ(hostbus_get_start_line(), (uint8_t)(-rows) & (SSD1306_HEIGHT - 1));
+    
+    // Each canvas pixel moves by rows along the panel's rows; the ones that
+    // run off the edge are exactly the band, and come back in on the other
+    // side in the background colour
+    int wrapped = 0;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int mx = x, my = y;
+            int *along = portrait ? &mx : &my;
+            *along += rows;
+            bool wraps = *along < 0 || *along >= SSD1306_HEIGHT;
+            *along &= SSD1306_HEIGHT - 1;
+            
+            bool in_band = x >= bx && x < bx + bw && y >= by && y < by + bh;
+            bool on = ssd1306_get_pixel(x, y);
+            int sx = 0, sy = 0;
+            to_screen(rotation, mirror, mx, my, &sx, &sy);
+            if (in_band != wraps || hostbus_get_screen_pixel(sx, sy) != on ||
+                on != (wraps ? BACKGROUND : pattern(x, y))) {
+                fprintf(stderr, "rotation %d%s, offset %d: canvas (%d, %d) should show "
+                        "at (%d, %d)%s\n", rotation * 90, mirror ? " mirrored" : "", rows,
+                        x, y, sx, sy, wraps ? " blank" : "");
+                exit(1);
+            }
+            wrapped += wraps;
+        }
+    }
+    CHECK_EQ(wrapped, (rows < 0 ? -rows : rows) * SSD1306_WIDTH);
+}
+
+int main(void) {
+    host_test_init();
+    host_test_reset();
+    for (int rotation = SSD1306_ROT_0; rotation <= SSD1306_ROT_270; rotation++) {
+        for (int mirror = 0; mirror < 2; mirror++) {
+            CHECK(ssd1306_set_orientation(rotation, mirror) == ESP_OK);
+            for (int i = 0; i < (int)(sizeof(offsets) / sizeof(offsets[0])); i++) {
+                check_offset(rotation, mirror, offsets[i]);
+            }
+        }
+    }
+    
+    // Back at no offset the panel holds the frame as drawn
+    CHECK(ssd1306_set_orientation(SSD1306_ROT_0, false) == ESP_OK);
+    host_test_draw_frame(1);
+    CHECK(host_test_flush());
+    CHECK(host_test_panel_matches());
+    return 0;
+}
@@ -0,0 +1,362 @@
+/*
+ * Frame Stream Decoder
+ * Turns the stream from framestream.h back into frames on a host
+ *
+ * Build:
+ *   cc -O2 -I main -o framestream_decode tools/framestream_decode.c
+ *
+ * Usage:
+ *   framestream_decode [-a addr] [-b baud] [-o out | -p pattern] [input]
+ *
+ *   input     File, FIFO or serial port to read (default stdin)
+ *   -a addr   Panel to show, e.g. 0x3D (default: the first one seen)
+ *   -b baud   Line rate when input is a serial port (default 921600)
+ *   -o out    Raw frames, 8-bit gray row-major, to a file or FIFO
+ *             ("-" = stdout, the default), e.g. for
+ *             ffplay -f rawvideo -pixel_format gray -video_size 128x64 -i -
+ *   -p pattern  One PBM file per frame instead, named with one %u for
+ *             the frame number
+ *
+ * Bytes outside packets (log lines sharing the port) are skipped. After a
+ * lost or damaged packet, frames are held back until the next key frame.
+ * Counts go to stderr at the end.
+ */
+
+#include "framestream_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define WIDTH   FRAMESTREAM_PAGE_BYTES
+#define HEIGHT  64
+#define PAGES   (HEIGHT / 8)
+
+// Longest packet after the sync bytes
+#define MAX_PACKET  (FRAMESTREAM_HEADER_BYTES + FRAMESTREAM_MAX_PAYLOAD + 2)
+
+typedef enum {
+    WAIT_SYNC0,
+    WAIT_SYNC1,
+    HEADER,
+    PAYLOAD,
+    CHECK,
+} parse_state_t;
+
+typedef struct {
+    // Packet parsing
+    parse_state_t state;
+    uint8_t packet[MAX_PACKET];
+    int len;
+    int covered;            // Page bytes the payload tokens so far cover
+    int need;               // Bytes still owed to the current token, or
+                            // check bytes still to come
+
+    // Stream state
+    bool seen_seq;
+    uint8_t next_seq;
+    int addr;               // Panel shown, -1 = take the first seen
+    bool synced;            // frame matches the panel
+    uint8_t key_pages;      // Key pages received since losing sync
+    uint8_t frame[PAGES * WIDTH];
+
+    // Counts
+    unsigned long frames, packets, bad_packets, lost_packets, skipped_bytes;
+} decoder_t;
+
+typedef struct {
+    FILE *raw;              // Raw output, or NULL for PBM files
+    const char *pattern;
+} output_t;
+
+// ============================================================================
+// OUTPUT
+// ============================================================================
+
+static inline bool pixel(const uint8_t *frame, int x, int y) {
+    return (frame[(y / 8) * WIDTH + x] >> (y & 7)) & 1;
+}
+
+static bool write_frame(const output_t *out, const uint8_t *frame, unsigned long number) {
+    if (out->raw) {
+        uint8_t row[WIDTH];
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) row[x] = pixel(frame, x, y) ? 0xFF : 0x00;
+            fwrite(row, 1, WIDTH, out->raw);
+        }
+        fflush(out->raw);   // Keep a player on the other end of a pipe in step
+        return !ferror(out->raw);
+    }
+
+    // PBM rows: MSB-first, 1 = black, so lit pixels are written as 0 bits
+    char path[512];
+    snprintf(path, sizeof(path), out->pattern, (unsigned)number);
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P4\n%d %d\n", WIDTH, HEIGHT);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x += 8) {
+            uint8_t byte = 0;
+            for (int b = 0; b < 8; b++) {
+                if (!pixel(frame, x + b, y)) byte |= 0x80 >> b;
+            }
+            fputc(byte, f);
+        }
+    }
+    bool failed = ferror(f);
+    fclose(f);
+    return !failed;
+}
+
+// ============================================================================
+// DECODING
+// ============================================================================
+
+// Expand a checked page payload, XORed into the page or over it
+static void apply_page(uint8_t *page, const uint8_t *payload, int len, bool xor) {
+    int col = 0;
+    for (int i = 0; i < len; ) {
+        uint8_t token = payload[i++];
+        int n;
+        if (token < FRAMESTREAM_REPEAT) {
+            n = token + 1;
+            if (!xor) memset(&page[col], 0, n);
+        } else if (token < FRAMESTREAM_LITERAL) {
+            n = (token & 0x3F) + 1;
+            uint8_t v = payload[i++];
+            for (int k = 0; k < n; k++) page[col + k] = xor ? page[col + k] ^ v : v;
+        } else {
+            n = (token & 0x3F) + 1;
+            for (int k = 0; k < n; k++) {
+                uint8_t v = payload[i++];
+                page[col + k] = xor ? page[col + k] ^ v : v;
+            }
+        }
+        col += n;
+    }
+}
+
+static void lose_sync(decoder_t *dec) {
+    dec->synced = false;
+    dec->key_pages = 0;
+}
+
+// A whole, checked packet. Returns false if output failed.
+static bool handle_packet(decoder_t *dec, const output_t *out) {
+    uint8_t type = dec->packet[0];
+    uint8_t seq = dec->packet[1];
+    uint8_t addr = dec->packet[2];
+    uint8_t arg = dec->packet[3];
+    const uint8_t *payload = &dec->packet[FRAMESTREAM_HEADER_BYTES];
+    int payload_len = dec->len - FRAMESTREAM_HEADER_BYTES - 2;
+
+    dec->packets++;
+    if (dec->seen_seq && seq != dec->next_seq) {
+        dec->lost_packets += (uint8_t)(seq - dec->next_seq);
+        lose_sync(dec);
+    }
+    dec->seen_seq = true;
+    dec->next_seq = seq + 1;
+
+    if (dec->addr < 0) dec->addr = addr;
+    if (addr != dec->addr) return true;
+
+    switch (type) {
+        case FRAMESTREAM_DELTA:
+            apply_page(&dec->frame[arg * WIDTH], payload, payload_len, true);
+            break;
+        case FRAMESTREAM_KEY:
+            apply_page(&dec->frame[arg * WIDTH], payload, payload_len, false);
+            dec->key_pages |= 1 << arg;
+            break;
+        case FRAMESTREAM_FRAME:
+            if (!dec->synced && dec->key_pages == 0xFF) dec->synced = true;
+            if (dec->synced) return write_frame(out, dec->frame, dec->frames++);
+            break;
+    }
+    return true;
+}
+
+// Packet rejected: count it and look for the next sync
+static void bad_packet(decoder_t *dec) {
+    dec->bad_packets++;
+    dec->state = WAIT_SYNC0;
+    lose_sync(dec);
+}
+
+static bool decode_byte(decoder_t *dec, const output_t *out, uint8_t byte) {
+    switch (dec->state) {
+        case WAIT_SYNC0:
+            if (byte == FRAMESTREAM_SYNC0) {
+                dec->state = WAIT_SYNC1;
+            } else {
+                dec->skipped_bytes++;
+            }
+            return true;
+
+        case WAIT_SYNC1:
+            if (byte == FRAMESTREAM_SYNC1) {
+                dec->state = HEADER;
+                dec->len = 0;
+            } else {
+                dec->skipped_bytes++;
+                dec->state = (byte == FRAMESTREAM_SYNC0) ? WAIT_SYNC1 : WAIT_SYNC0;
+            }
+            return true;
+
+        case HEADER: {
+            dec->packet[dec->len++] = byte;
+            if (dec->len < FRAMESTREAM_HEADER_BYTES) return true;
+
+            uint8_t type = dec->packet[0];
+            uint8_t arg = dec->packet[3];
+            if (type == FRAMESTREAM_FRAME) {
+                dec->state = CHECK;
+                dec->need = 2;
+            } else if ((type == FRAMESTREAM_DELTA || type == FRAMESTREAM_KEY) && arg < PAGES) {
+                dec->state = PAYLOAD;
+                dec->covered = 0;
+                dec->need = 0;
+            } else {
+                bad_packet(dec);
+            }
+            return true;
+        }
+
+        case PAYLOAD:
+            if (dec->len >= MAX_PACKET - 2) {
+                bad_packet(dec);
+                return true;
+            }
+            dec->packet[dec->len++] = byte;
+            if (dec->need > 0) {
+                dec->need--;
+            } else if (byte < FRAMESTREAM_REPEAT) {
+                dec->covered += byte + 1;
+            } else if (byte < FRAMESTREAM_LITERAL) {
+                dec->covered += (byte & 0x3F) + 1;
+                dec->need = 1;
+            } else {
+                dec->covered += (byte & 0x3F) + 1;
+                dec->need = (byte & 0x3F) + 1;
+            }
+            if (dec->covered > FRAMESTREAM_PAGE_BYTES) {
+                bad_packet(dec);
+            } else if (dec->covered == FRAMESTREAM_PAGE_BYTES && dec->need == 0) {
+                dec->state = CHECK;
+                dec->need = 2;
+            }
+            return true;
+
+        case CHECK: {
+            dec->packet[dec->len++] = byte;
+            if (--dec->need > 0) return true;
+
+            framestream_check_t check = {0, 0};
+            for (int i = 0; i < dec->len - 2; i++) framestream_check_add(&check, dec->packet[i]);
+            if (check.a != dec->packet[dec->len - 2] || check.b != dec->packet[dec->len - 1]) {
+                bad_packet(dec);
+                return true;
+            }
+            dec->state = WAIT_SYNC0;
+            return handle_packet(dec, out);
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// INPUT
+// ============================================================================
+
+static speed_t baud_constant(long baud) {
+    switch (baud) {
+        case 115200: return B115200;
+        case 230400: return B230400;
+#ifdef B460800
+        case 460800: return B460800;
+#endif
+#ifdef B921600
+        case 921600: return B921600;
+#endif
+#ifdef B1500000
+        case 1500000: return B1500000;
+#endif
+#ifdef B2000000
+        case 2000000: return B2000000;
+#endif
+        default: return 0;
+    }
+}
+
+// Put a serial port (or pty) in raw mode at the given rate
+static bool setup_tty(int fd, long baud) {
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) return false;
+    cfmakeraw(&tio);
+    speed_t speed = baud_constant(baud);
+    if (!speed) {
+        fprintf(stderr, "Unsupported baud rate %ld\n", baud);
+        return false;
+    }
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+int main(int argc, char **argv) {
+    decoder_t dec = {.addr = -1};
+    const char *out_path = "-";
+    const char *pattern = NULL;
+    long baud = 921600;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:b:o:p:")) != -1) {
+        switch (opt) {
+            case 'a': dec.addr = (int)strtol(optarg, NULL, 0); break;
+            case 'b': baud = strtol(optarg, NULL, 0); break;
+            case 'o': out_path = optarg; break;
+            case 'p': pattern = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-a addr] [-b baud] [-o out | -p pattern] [input]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    int fd = STDIN_FILENO;
+    if (optind < argc) {
+        fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+        if (fd < 0) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+    if (isatty(fd) && !setup_tty(fd, baud)) {
+        fprintf(stderr, "Can't set up %s as a serial port\n", optind < argc ? argv[optind] : "stdin");
+        return 1;
+    }
+
+    output_t out = {.pattern = pattern};
+    if (!pattern) {
+        out.raw = (strcmp(out_path, "-") == 0) ? stdout : fopen(out_path, "wb");
+        if (!out.raw) {
+            perror(out_path);
+            return 1;
+        }
+    }
+
+    uint8_t buf[4096];
+    ssize_t n;
+    bool ok = true;
+    while (ok && (n = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n && ok; i++) ok = decode_byte(&dec, &out, buf[i]);
+    }
+
+    fprintf(stderr, "%lu frames from %lu packets (%lu damaged, %lu lost, %lu stray bytes)\n",
+            dec.frames, dec.packets, dec.bad_packets, dec.lost_packets, dec.skipped_bytes);
+    if (out.raw && out.raw != stdout) fclose(out.raw);
+    return ok ? 0 : 1;
+}